@@ -0,0 +1,60 @@
+# ===============================================
+#  bubble_sort.asm
+#  Fills a 256-word array at 0x10000 with pseudo-random 16-bit values
+#  (LCG: x = x * 1103515245 + 12345, value = x >> 16) and bubble sorts it.
+#  a0 (x10) = sum of a[i] * (i + 1) over the sorted array.
+# ===============================================
+
+.text
+_start:
+    lui   s0, 0x10            # s0 = array base
+    li    s1, 256             # s1 = n
+
+    li    t0, 12345           # LCG state
+    li    t1, 1103515245
+    li    t2, 12345
+    li    t3, 16
+    mv    t4, s0
+    mv    t5, s1
+fill:
+    mul   t0, t0, t1
+    add   t0, t0, t2
+    srl   t6, t0, t3
+    sw    t6, 0(t4)
+    addi  t4, t4, 4
+    addi  t5, t5, -1
+    bne   t5, x0, fill
+
+    addi  s2, s1, -1          # i = n - 1 comparisons in the first pass
+outer:
+    mv    t4, s0
+    mv    t5, s2
+inner:
+    lw    t0, 0(t4)
+    lw    t1, 4(t4)
+    bge   t1, t0, no_swap
+    sw    t1, 0(t4)
+    sw    t0, 4(t4)
+no_swap:
+    addi  t4, t4, 4
+    addi  t5, t5, -1
+    bne   t5, x0, inner
+    addi  s2, s2, -1
+    bne   s2, x0, outer
+
+    # Weighted checksum of the sorted array
+    li    a0, 0
+    li    t2, 1               # weight
+    mv    t4, s0
+    mv    t5, s1
+check:
+    lw    t0, 0(t4)
+    mul   t0, t0, t2
+    add   a0, a0, t0
+    addi  t2, t2, 1
+    addi  t4, t4, 4
+    addi  t5, t5, -1
+    bne   t5, x0, check
+
+halt:
+    beq   x0, x0, halt
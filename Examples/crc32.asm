@@ -0,0 +1,58 @@
+# ===============================================
+#  crc32.asm
+#  Bitwise CRC-32 (reflected, polynomial 0xEDB88320) of a 4 KiB buffer at
+#  0x10000 filled with LCG words (x = x * 1664525 + 1013904223, x0 = 1).
+#  The buffer is read a word at a time, low byte first, so a0 (x10) matches
+#  the standard CRC-32 of the little-endian bytes.
+# ===============================================
+
+.text
+_start:
+    lui   s0, 0x10            # buffer
+    li    s1, 1024            # words
+
+    li    t0, 1
+    li    t1, 1664525
+    li    t2, 1013904223
+    mv    t3, s0
+    mv    t4, s1
+fill:
+    mul   t0, t0, t1
+    add   t0, t0, t2
+    sw    t0, 0(t3)
+    addi  t3, t3, 4
+    addi  t4, t4, -1
+    bne   t4, x0, fill
+
+    li    a0, -1              # crc
+    li    s2, 0xEDB88320      # polynomial
+    li    s3, 0xFF
+    li    s4, 1
+    li    s5, 8
+    mv    t3, s0
+    mv    t4, s1
+word_loop:
+    lw    t0, 0(t3)
+    li    t5, 4               # bytes left in the word
+byte_loop:
+    and   t1, t0, s3
+    xor   a0, a0, t1
+    srl   t0, t0, s5
+    li    t6, 8               # bits left in the byte
+bit_loop:
+    and   t1, a0, s4
+    sub   t1, x0, t1          # all ones if the low bit is set
+    and   t1, t1, s2
+    srl   a0, a0, s4
+    xor   a0, a0, t1
+    addi  t6, t6, -1
+    bne   t6, x0, bit_loop
+    addi  t5, t5, -1
+    bne   t5, x0, byte_loop
+    addi  t3, t3, 4
+    addi  t4, t4, -1
+    bne   t4, x0, word_loop
+    not   a0, a0
+
+halt:
+    beq   x0, x0, halt
@@ -0,0 +1,34 @@
+# ===============================================
+#  fib.asm
+#  Recursive Fibonacci: a0 (x10) = fib(22), using jal/jalr calls and a stack
+#  growing down from 0x80000.
+# ===============================================
+
+.text
+_start:
+    lui   sp, 0x80
+    li    a0, 22
+    jal   ra, fib
+
+halt:
+    beq   x0, x0, halt
+
+# fib(a0) -> a0
+fib:
+    li    t0, 2
+    blt   a0, t0, fib_return  # fib(0) = 0, fib(1) = 1
+    addi  sp, sp, -12
+    sw    ra, 0(sp)
+    sw    a0, 4(sp)
+    addi  a0, a0, -1
+    jal   ra, fib
+    sw    a0, 8(sp)           # fib(n - 1)
+    lw    a0, 4(sp)
+    addi  a0, a0, -2
+    jal   ra, fib
+    lw    t1, 8(sp)
+    add   a0, a0, t1
+    lw    ra, 0(sp)
+    addi  sp, sp, 12
+fib_return:
+    jalr  x0, ra, 0
@@ -0,0 +1,80 @@
+# ===============================================
+#  matmul.asm
+#  C = A * B for 32x32 word matrices, with A[i][j] = i + j and B[i][j] = i - j.
+#  A is at 0x10000, B at 0x11000 and C at 0x12000 (row-major, 128-byte rows).
+#  a0 (x10) = hash of C: h = h * 31 + C[k] over all elements in order.
+# ===============================================
+
+.text
+_start:
+    li    s0, 32              # N
+    lui   s1, 0x10            # A
+    lui   s2, 0x11            # B
+    lui   s3, 0x12            # C
+    li    s4, 128             # row stride in bytes
+
+    # Fill A and B
+    li    t0, 0               # i
+fill_i:
+    li    t1, 0               # j
+fill_j:
+    mul   t2, t0, s0
+    add   t2, t2, t1
+    add   t2, t2, t2
+    add   t2, t2, t2          # t2 = (i * N + j) * 4
+    add   t3, s1, t2
+    add   t4, t0, t1
+    sw    t4, 0(t3)
+    add   t3, s2, t2
+    sub   t4, t0, t1
+    sw    t4, 0(t3)
+    addi  t1, t1, 1
+    blt   t1, s0, fill_j
+    addi  t0, t0, 1
+    blt   t0, s0, fill_i
+
+    # Multiply
+    li    t0, 0               # i
+    mv    a1, s1              # &A[i][0]
+    mv    a2, s3              # &C[i][j]
+mm_i:
+    li    t1, 0               # j
+    mv    a3, s2              # &B[0][j]
+mm_j:
+    li    t6, 0               # sum
+    mv    a4, a1
+    mv    a5, a3
+    mv    t2, s0              # k countdown
+mm_k:
+    lw    t3, 0(a4)
+    lw    t4, 0(a5)
+    mul   t5, t3, t4
+    add   t6, t6, t5
+    addi  a4, a4, 4
+    add   a5, a5, s4
+    addi  t2, t2, -1
+    bne   t2, x0, mm_k
+    sw    t6, 0(a2)
+    addi  a2, a2, 4
+    addi  a3, a3, 4
+    addi  t1, t1, 1
+    blt   t1, s0, mm_j
+    add   a1, a1, s4
+    addi  t0, t0, 1
+    blt   t0, s0, mm_i
+
+    # Hash C
+    li    a0, 0
+    li    t5, 31
+    mv    t3, s3
+    mul   t4, s0, s0          # element count
+hash:
+    lw    t0, 0(t3)
+    mul   a0, a0, t5
+    add   a0, a0, t0
+    addi  t3, t3, 4
+    addi  t4, t4, -1
+    bne   t4, x0, hash
+
+halt:
+    beq   x0, x0, halt
@@ -0,0 +1,51 @@
+# ===============================================
+#  memcpy.asm
+#  Copies a 1 KiB block (256 words) from 0x10000 to 0x20000, 256 times.
+#  The checksum (sum of the copied words) is left in a0 (x10).
+# ===============================================
+
+.text
+_start:
+    lui   s0, 0x10            # s0 = source
+    lui   s1, 0x20            # s1 = destination
+    li    s2, 256             # words per copy
+
+    # Fill the source block: src[i] = i * 0x9E3779B9
+    li    t0, 0x9E3779B9
+    li    t1, 0               # i
+    mv    t2, s0
+fill:
+    mul   t3, t1, t0
+    sw    t3, 0(t2)
+    addi  t2, t2, 4
+    addi  t1, t1, 1
+    blt   t1, s2, fill
+
+    li    s3, 256             # number of copies
+copy_round:
+    mv    t1, s0
+    mv    t2, s1
+    mv    t4, s2
+copy_loop:
+    lw    t3, 0(t1)
+    sw    t3, 0(t2)
+    addi  t1, t1, 4
+    addi  t2, t2, 4
+    addi  t4, t4, -1
+    bne   t4, x0, copy_loop
+    addi  s3, s3, -1
+    bne   s3, x0, copy_round
+
+    # Checksum the destination block
+    li    a0, 0
+    mv    t2, s1
+    mv    t4, s2
+sum_loop:
+    lw    t3, 0(t2)
+    add   a0, a0, t3
+    addi  t2, t2, 4
+    addi  t4, t4, -1
+    bne   t4, x0, sum_loop
+
+halt:
+    beq   x0, x0, halt
@@ -0,0 +1,48 @@
+# ===============================================
+#  sieve.asm
+#  Sieve of Eratosthenes over 0..16383 with one word flag per number at 0x10000.
+#  a0 (x10) = number of primes below 16384.
+# ===============================================
+
+.text
+_start:
+    lui   s0, 0x10            # flags
+    li    s1, 16384           # N
+    add   s2, s1, s1
+    add   s2, s2, s2
+    add   s2, s2, s0          # s2 = &flags[N]
+
+    li    t0, 1
+    mv    t1, s0
+init:
+    sw    t0, 0(t1)
+    addi  t1, t1, 4
+    blt   t1, s2, init
+
+    li    a0, 0               # prime count
+    li    t0, 2               # p
+outer:
+    bge   t0, s1, halt
+    add   t1, t0, t0
+    add   t1, t1, t1
+    add   t1, t1, s0
+    lw    t2, 0(t1)
+    beq   t2, x0, next
+    addi  a0, a0, 1
+    mul   t3, t0, t0          # first multiple to strike: p * p
+    bge   t3, s1, next
+    add   t4, t0, t0
+    add   t4, t4, t4          # stride in bytes: 4 * p
+    add   t5, t3, t3
+    add   t5, t5, t5
+    add   t5, t5, s0          # &flags[p * p]
+mark:
+    sw    x0, 0(t5)
+    add   t5, t5, t4
+    blt   t5, s2, mark
+next:
+    addi  t0, t0, 1
+    jal   x0, outer
+
+halt:
+    beq   x0, x0, halt
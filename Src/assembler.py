@@ -3,6 +3,7 @@
 # It now correctly handles labels on the same line as instructions/directives.
 # It also includes a more robust parser for complex instructions and modifiers.
 
+import bisect
 import struct
 import sys
 import os
@@ -51,6 +52,11 @@ def to_binary(n, bits, signed=True):
 def clean_line(line):
     return line.split('#')[0].strip()
 
+def read_lines(path):
+    # Non-blank source lines of path with comments removed, as the two passes take them.
+    with open(path, 'r', encoding='utf-8') as f:
+        return [clean_line(line) for line in f if clean_line(line)]
+
 def parse_immediate(imm_str, symbol_table):
     imm_str = imm_str.strip()
     match = re.match(r'%(hi|lo)\((.+)\)', imm_str)
@@ -104,41 +110,21 @@ def expand_pseudo_instructions(line, symbol_table):
 
 # --- Main Assembler Logic  ---
 
-def first_pass(lines):
-    symbol_table = {}
+def layout(lines):
+    # The location-counter walk shared by first_pass and source_map: yields
+    # (index into lines, label, address) for each label definition and
+    # (index into lines, None, address) for each instruction emitted.
     location_counter = 0x1000
-    temp_symbol_table = {} 
-    
-    temp_lc = 0x1000
-    for line in lines:
-        parts = line.split()
-        if not parts: continue
-        if parts[0].endswith(':'):
-            temp_symbol_table[parts[0][:-1]] = temp_lc
-        else:
-            op = parts[0]
-            if op == 'li' or op == 'la': temp_lc += 8
-            elif op.startswith('.'):
-                directive_parts = line.split()
-                if op == '.word': temp_lc += 4 * (len(directive_parts) - 1)
-                elif op == '.half': temp_lc += 2 * (len(directive_parts) - 1)
-                elif op == '.byte': temp_lc += 1 * (len(directive_parts) - 1)
-            else: temp_lc += 4
-
-    for line in lines:
+    for index, line in enumerate(lines):
         parts = line.split()
         if not parts: continue
 
         if parts[0].endswith(':'):
-            label = parts[0][:-1]
-            symbol_table[label] = location_counter
+            yield index, parts[0][:-1], location_counter
             parts = parts[1:]
             if not parts: continue
-        
-        line_content = " ".join(parts)
-        expanded_lines = expand_pseudo_instructions(line_content, temp_symbol_table)
-        
-        for expanded_line in expanded_lines:
+
+        for expanded_line in expand_pseudo_instructions(" ".join(parts), {}):
             op = expanded_line.split()[0]
             if op.startswith('.'):
                 directive_parts = expanded_line.split()
@@ -150,8 +136,42 @@ def first_pass(lines):
                     padding = (alignment - (location_counter % alignment)) % alignment
                     location_counter += padding
             else:
+                yield index, None, location_counter
                 location_counter += 4
-    return symbol_table
+
+def first_pass(lines):
+    return {label: address for _, label, address in layout(lines) if label is not None}
+
+def source_map(raw_lines):
+    # Maps the address of every emitted instruction to (line number, source text).
+    return {address: (index + 1, raw_lines[index].strip())
+            for index, label, address in layout([clean_line(line) for line in raw_lines]) if label is None}
+
+class Symbolizer:
+    """Turns pcs into `label+offset` and source lines using the assembler's view of the program."""
+    def __init__(self, symbol_table=None, lines=None):
+        self.symbol_table = dict(symbol_table or {})
+        labels = sorted((address, label) for label, address in self.symbol_table.items())
+        self.addresses = [address for address, _ in labels]
+        self.labels = [label for _, label in labels]
+        self.lines = lines or {}
+
+    @classmethod
+    def from_source(cls, path):
+        with open(path, 'r', encoding='utf-8') as f:
+            raw_lines = f.readlines()
+        return cls(first_pass([clean_line(line) for line in raw_lines if clean_line(line)]), source_map(raw_lines))
+
+    def label(self, pc):
+        """Nearest label at or below pc, or None."""
+        i = bisect.bisect_right(self.addresses, pc) - 1
+        return self.labels[i] if i >= 0 else None
+
+    def describe(self, pc):
+        i = bisect.bisect_right(self.addresses, pc) - 1
+        if i < 0: return f"{pc:#x}"
+        offset = pc - self.addresses[i]
+        return self.labels[i] if offset == 0 else f"{self.labels[i]}+{offset:#x}"
 
 def second_pass(lines, symbol_table):
     output_bytes = bytearray()
@@ -0,0 +1,178 @@
+# RISC-V simulator benchmark suite.
+# Assembles the kernels in Examples/, runs each one on every engine and reports
+# instructions/sec (MIPS), peak Python heap use per run and assembler lines/sec. Each
+# kernel's result register is checked against a Python reference so a fast but wrong
+# engine fails the run. Results can be saved as JSON and compared against an earlier
+# file to catch regressions between versions.
+#
+# Usage: python benchmark.py [--engines interp,block,jit] [--kernels fib,sieve]
+#                            [--output results.json] [--baseline old.json]
+
+import argparse
+import json
+import os
+import platform
+import sys
+import time
+import tracemalloc
+import zlib
+
+import assembler
+from simulator_core import RISCVSimulator
+
+EXAMPLES = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'Examples')
+BUDGET = 50_000_000
+FORMAT_VERSION = 1
+
+# --- Python references for each kernel's a0 ---
+
+def _lcg(x, a, c, count):
+    for _ in range(count):
+        x = (x * a + c) & 0xFFFFFFFF
+        yield x
+
+def _memcpy():
+    return sum(i * 0x9E3779B9 for i in range(256)) & 0xFFFFFFFF
+
+def _bubble_sort():
+    values = sorted(x >> 16 for x in _lcg(12345, 1103515245, 12345, 256))
+    return sum(v * (i + 1) for i, v in enumerate(values)) & 0xFFFFFFFF
+
+def _matmul():
+    n, h = 32, 0
+    for i in range(n):
+        for j in range(n):
+            h = (h * 31 + sum((i + k) * (k - j) for k in range(n))) & 0xFFFFFFFF
+    return h
+
+def _crc32():
+    return zlib.crc32(b''.join(x.to_bytes(4, 'little') for x in _lcg(1, 1664525, 1013904223, 1024)))
+
+def _sieve():
+    n = 16384
+    flags = bytearray([1]) * n
+    for p in range(2, int(n ** 0.5) + 1):
+        if flags[p]: flags[p * p::p] = bytes(len(range(p * p, n, p)))
+    return sum(flags[2:])
+
+def _fib():
+    a, b = 0, 1
+    for _ in range(22): a, b = b, a + b
+    return a
+
+# name -> expected a0 after the program halts
+KERNELS = {
+    'factorial': lambda: 5040,
+    'memcpy': _memcpy,
+    'bubble_sort': _bubble_sort,
+    'matmul': _matmul,
+    'crc32': _crc32,
+    'sieve': _sieve,
+    'fib': _fib,
+}
+
+def read_source(name):
+    return assembler.read_lines(os.path.join(EXAMPLES, f'{name}.asm'))
+
+def bench_assembler(lines, min_seconds=0.2):
+    """Returns (program bytes, source lines per second)."""
+    passes, start = 0, time.perf_counter()
+    while True:
+        image = bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+        passes += 1
+        elapsed = time.perf_counter() - start
+        if elapsed >= min_seconds: return image, passes * len(lines) / elapsed
+
+def run_once(engine, image):
+    sim = RISCVSimulator(engine=engine)
+    sim.load_image(image)
+    start = time.perf_counter()
+    result = sim.run(BUDGET)
+    return sim, result, time.perf_counter() - start
+
+def peak_memory(engine, image):
+    """Peak bytes allocated by Python while loading and running image (traced separately from timing)."""
+    tracemalloc.start()
+    try:
+        run_once(engine, image)
+        return tracemalloc.get_traced_memory()[1]
+    finally:
+        tracemalloc.stop()
+
+def compare(results, baseline, threshold):
+    """Prints per-entry speed ratios against baseline; returns the entries slower than threshold allows."""
+    old = {(r['kernel'], r['engine']): r for r in baseline.get('results', [])}
+    regressions = []
+    for r in results:
+        before = old.get((r['kernel'], r['engine']))
+        if before is None or not before['mips']: continue
+        ratio = r['mips'] / before['mips']
+        flag = ''
+        if ratio < 1 - threshold:
+            flag = '  <-- regression'
+            regressions.append(r)
+        print(f"{r['kernel']:<12} {r['engine']:<7} {before['mips']:8.3f} -> {r['mips']:8.3f} MIPS ({ratio:5.2f}x){flag}")
+    return regressions
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Benchmark the simulator engines and the assembler.")
+    parser.add_argument('--engines', default=','.join(RISCVSimulator.ENGINES))
+    parser.add_argument('--kernels', default=','.join(KERNELS))
+    parser.add_argument('--repeat', type=int, default=3, help="timed runs per kernel and engine (best is kept)")
+    parser.add_argument('--no-memory', action='store_true', help="skip the (slow) traced peak-memory run")
+    parser.add_argument('--output', help="write the results to this JSON file")
+    parser.add_argument('--baseline', help="compare against an earlier JSON results file")
+    parser.add_argument('--threshold', type=float, default=0.10,
+                        help="relative MIPS drop reported as a regression (default 0.10)")
+    args = parser.parse_args(argv)
+    engines = args.engines.split(',')
+    kernels = args.kernels.split(',')
+    for engine in engines:
+        if engine not in RISCVSimulator.ENGINES: parser.error(f"unknown engine '{engine}'")
+    for name in kernels:
+        if name not in KERNELS: parser.error(f"unknown kernel '{name}'")
+
+    results, assembly, failed = [], [], False
+    print(f"{'kernel':<12} {'engine':<7} {'instructions':>12} {'seconds':>8} {'MIPS':>8} {'peak KiB':>9}")
+    for name in kernels:
+        lines = read_source(name)
+        image, lines_per_second = bench_assembler(lines)
+        assembly.append({'kernel': name, 'lines': len(lines), 'lines_per_second': lines_per_second})
+        expected = KERNELS[name]()
+        for engine in engines:
+            best = None
+            for _ in range(args.repeat):
+                sim, result, seconds = run_once(engine, image)
+                if best is None or seconds < best[2]: best = (sim, result, seconds)
+            sim, result, seconds = best
+            ok = sim.registers[10] == expected
+            failed |= not ok
+            peak = None if args.no_memory else peak_memory(engine, image)
+            entry = {'kernel': name, 'engine': engine, 'instructions': result.instructions,
+                     'seconds': seconds, 'mips': result.instructions / seconds / 1e6 if seconds else 0.0,
+                     'peak_memory': peak, 'reason': result.reason.value, 'ok': ok}
+            results.append(entry)
+            peak_text = '-' if peak is None else f"{peak / 1024:.0f}"
+            status = '' if ok else f"  WRONG a0={sim.registers[10]} (expected {expected})"
+            print(f"{name:<12} {engine:<7} {result.instructions:>12} {seconds:>8.3f} {entry['mips']:>8.3f} "
+                  f"{peak_text:>9}{status}")
+    print()
+    for a in assembly:
+        print(f"assembler   {a['kernel']:<12} {a['lines']:>4} lines  {a['lines_per_second']:>10.0f} lines/s")
+
+    report = {'version': FORMAT_VERSION, 'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S'),
+              'python': platform.python_version(), 'platform': platform.platform(),
+              'results': results, 'assembler': assembly}
+    if args.output:
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump(report, f, indent=2)
+        print(f"Results written to '{args.output}'.")
+    if args.baseline:
+        with open(args.baseline, 'r', encoding='utf-8') as f:
+            baseline = json.load(f)
+        print(f"\nCompared with '{args.baseline}' ({baseline.get('timestamp', 'unknown date')}):")
+        failed |= bool(compare(results, baseline, args.threshold))
+    return 1 if failed else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,118 @@
+# Hot-spot profiler for guest programs.
+# Runs a program with RISCVSimulator profiling enabled and prints where the instructions
+# went: by label (from the assembler's Symbolizer), by source line and by
+# basic block. For .bin images there is no source, so the report lists pcs with their
+# disassembly instead. With --folded it also samples the shadow call stack and writes
+# folded stacks for flame-graph tools (e.g. `flamegraph.pl out.folded > out.svg`).
+#
+# Usage: python profiler.py program.{asm,bin} [-n MAX] [--engine block] [--top 15]
+#                           [--folded out.folded] [--period 1000]
+
+import argparse
+import sys
+
+from assembler import Symbolizer
+from simulator_cli import assemble
+from simulator_core import RISCVSimulator, StopReason
+
+def report(profile, sim, symbolizer=None, top=15, sampler=None):
+    """Formats a ranked hot-spot report of profile (collected on sim) as text.
+
+    With a CallStackSampler, adds the sampled inclusive share of each function (its
+    own code plus everything it called).
+    """
+    symbolizer = symbolizer or Symbolizer()
+    counts = profile.instruction_counts()
+    total = sum(counts.values()) or 1
+    out = [f"Profile: {total} instructions at {len(counts)} distinct pcs"]
+
+    def section(title, header, rows):
+        out.append("")
+        out.append(title)
+        out.append(header)
+        for row in rows[:top]:
+            out.append(row)
+
+    by_label = {}
+    for pc, count in counts.items():
+        label = symbolizer.label(pc) or '(no label)'
+        by_label[label] = by_label.get(label, 0) + count
+    ranked = sorted(by_label.items(), key=lambda item: -item[1])
+    section("By label:", f"{'instructions':>12} {'share':>6}  label",
+            [f"{count:>12} {100 * count / total:>5.1f}%  {label}" for label, count in ranked])
+
+    if symbolizer.lines:
+        by_line = {}
+        for pc, count in counts.items():
+            line = symbolizer.lines.get(pc)
+            if line is not None: by_line[line] = by_line.get(line, 0) + count
+        ranked = sorted(by_line.items(), key=lambda item: -item[1])
+        section("By source line:", f"{'instructions':>12} {'share':>6}  {'line':>5}  source",
+                [f"{count:>12} {100 * count / total:>5.1f}%  {number:>5}  {text}"
+                 for (number, text), count in ranked])
+    else:
+        ranked = sorted(counts.items(), key=lambda item: -item[1])
+        section("By pc:", f"{'instructions':>12} {'share':>6}  {'pc':>10}  instruction",
+                [f"{count:>12} {100 * count / total:>5.1f}%  {pc:#010x}  {sim.disassemble(pc)}"
+                 for pc, count in ranked])
+
+    if sampler is not None and sampler.samples:
+        samples = sum(sampler.samples.values())
+        inclusive = {}
+        for stack, count in sampler.samples.items():
+            for name in {symbolizer.describe(pc) for pc in stack}:
+                inclusive[name] = inclusive.get(name, 0) + count
+        ranked = sorted(inclusive.items(), key=lambda item: (-item[1], item[0]))
+        section(f"Inclusive, sampled ({samples} samples every {sampler.period} instructions):",
+                f"{'samples':>12} {'share':>6}  function",
+                [f"{count:>12} {100 * count / samples:>5.1f}%  {name}" for name, count in ranked])
+
+    blocks = profile.basic_blocks(sim.decode_cache)
+    blocks.sort(key=lambda block: -block[2] * (block[1] - block[0]))
+    section("Hottest basic blocks:", f"{'instructions':>12} {'share':>6} {'entries':>10}  range",
+            [f"{entries * (end - start) // 4:>12} {100 * entries * (end - start) / 4 / total:>5.1f}% {entries:>10}  "
+             f"{start:#x}-{end - 4:#x} ({symbolizer.describe(start)})" for start, end, entries in blocks])
+    return "\n".join(out)
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Profile a RISC-V program and report its hot spots.")
+    parser.add_argument('program', help=".asm source (symbolized report) or .bin image")
+    parser.add_argument('-n', '--max-instructions', type=int, default=100_000_000)
+    parser.add_argument('--engine', choices=RISCVSimulator.ENGINES, default='block')
+    parser.add_argument('--top', type=int, default=15, help="rows per report section")
+    parser.add_argument('--folded', metavar='FILE', help="sample the call stack and write folded stacks here ('-' for stdout)")
+    parser.add_argument('--period', type=int, default=1000, help="instructions between call-stack samples")
+    args = parser.parse_args(argv)
+
+    sim = RISCVSimulator(engine=args.engine)
+    try:
+        if args.program.endswith('.asm'):
+            sim.load_image(assemble(args.program))
+            symbolizer = Symbolizer.from_source(args.program)
+        else:
+            with open(args.program, 'rb') as f:
+                sim.load_image(f.read())
+            symbolizer = Symbolizer()
+    except FileNotFoundError:
+        print(f"Error: File '{args.program}' not found.", file=sys.stderr)
+        return 1
+    except (ValueError, KeyError) as e:
+        print(f"Assembly Error: {e}", file=sys.stderr)
+        return 1
+
+    profile = sim.enable_profiling()
+    sampler = sim.enable_sampling(args.period) if args.folded else None
+    result = sim.run(args.max_instructions)
+    if sampler is not None:
+        folded = "\n".join(sampler.folded(symbolizer.describe)) + "\n"
+        if args.folded == '-':
+            sys.stdout.write(folded)
+        else:
+            with open(args.folded, 'w', encoding='utf-8') as f:
+                f.write(folded)
+    print(report(profile, sim, symbolizer, args.top, sampler))
+    print(f"\nStopped: {result.reason.value} at pc {sim.pc:#010x}")
+    return 2 if result.reason is StopReason.TRAP else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,104 @@
+# Headless RISC-V simulator runner.
+# Loads a .bin image (or assembles a .asm file in-process), runs it to halt or an
+# instruction budget, then prints the final registers, any requested memory ranges and
+# the run statistics (instructions retired, wall time, MIPS). No display is needed, so it
+# can be scripted for batch runs and CI. --stats writes the simulator's instruction-mix
+# counters as JSON and --trace a compressed execution trace (see tracefile.py).
+#
+# Usage: python simulator_cli.py program.{bin,asm} [-n MAX] [--engine block] [--dump 0x1000:64]
+#                                [--stats stats.json] [--trace run.rvt]
+
+import argparse
+import json
+import sys
+import time
+
+import assembler
+from simulator_core import ABI_NAMES, RISCVSimulator, StopReason, hexdump_lines
+from tracefile import TraceWriter
+
+CHUNK = 1 << 20  # instructions per run() call when no budget is given
+
+def assemble(path):
+    """Assembles path in-process; returns the program bytes."""
+    lines = assembler.read_lines(path)
+    return bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+
+def parse_range(text):
+    """'ADDR:LEN' (either part decimal or 0x-prefixed hex) -> (addr, length)."""
+    addr, _, length = text.partition(':')
+    return int(addr, 0), int(length or '16', 0)
+
+def run(sim, max_instructions, stop_pcs):
+    """Runs to a stop condition; returns (RunResult of the last call, total retired, seconds)."""
+    retired = 0
+    start = time.perf_counter()
+    while True:
+        budget = CHUNK if max_instructions is None else max_instructions - retired
+        result = sim.run(min(budget, CHUNK), stop_pcs)
+        retired += result.instructions
+        if result.reason is not StopReason.BUDGET: break
+        if max_instructions is not None and retired >= max_instructions: break
+    return result, retired, time.perf_counter() - start
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Run a RISC-V program without the GUI.")
+    parser.add_argument('program', help=".bin image or .asm source (assembled in-process)")
+    parser.add_argument('-n', '--max-instructions', type=int, default=None,
+                        help="instruction budget (default: run until the program stops)")
+    parser.add_argument('--engine', choices=RISCVSimulator.ENGINES, default='block')
+    parser.add_argument('--stop-pc', action='append', default=[], type=lambda v: int(v, 0),
+                        help="stop when the pc reaches this address (repeatable)")
+    parser.add_argument('--dump', action='append', default=[], type=parse_range, metavar='ADDR:LEN',
+                        help="print LEN bytes of memory from ADDR after the run (repeatable)")
+    parser.add_argument('-q', '--quiet', action='store_true', help="do not print the register file")
+    parser.add_argument('--json', action='store_true', help="print one JSON object instead of text")
+    parser.add_argument('--stats', metavar='FILE', help="write instruction-mix statistics as JSON to FILE")
+    parser.add_argument('--trace', metavar='FILE', help="write an execution trace to FILE (runs interpreted)")
+    args = parser.parse_args(argv)
+
+    sim = RISCVSimulator(engine=args.engine)
+    try:
+        if args.program.endswith('.asm'):
+            sim.load_image(assemble(args.program))
+        else:
+            with open(args.program, 'rb') as f:
+                sim.load_image(f.read())
+    except FileNotFoundError:
+        print(f"Error: File '{args.program}' not found.", file=sys.stderr)
+        return 1
+    except (ValueError, KeyError) as e:
+        print(f"Assembly Error: {e}", file=sys.stderr)
+        return 1
+
+    if args.trace:
+        with TraceWriter(args.trace) as writer:
+            sim.enable_tracing(writer)
+            result, retired, seconds = run(sim, args.max_instructions, args.stop_pc)
+            sim.disable_tracing()
+    else:
+        result, retired, seconds = run(sim, args.max_instructions, args.stop_pc)
+    mips = retired / seconds / 1e6 if seconds > 0 else 0.0
+    stats = sim.stats.summary()
+    if args.stats:
+        with open(args.stats, 'w', encoding='utf-8') as f:
+            json.dump(stats, f, indent=2)
+
+    if args.json:
+        report = {'program': args.program, 'engine': args.engine, 'reason': result.reason.value,
+                  'pc': sim.pc, 'instructions': retired, 'seconds': seconds, 'mips': mips,
+                  'registers': list(sim.registers), 'statistics': stats,
+                  'memory': {f"{addr:#x}": sim.memory[addr:addr + length].hex() for addr, length in args.dump}}
+        print(json.dumps(report))
+    else:
+        if not args.quiet:
+            for i in range(0, 32, 4):
+                print("   ".join(f"x{r:<2} ({ABI_NAMES[r]:>4}) = {sim.registers[r]:#010x}" for r in range(i, i + 4)))
+        for addr, length in args.dump:
+            print('\n'.join(hexdump_lines(sim.memory, addr, length)))
+        print(f"Stopped: {result.reason.value} at pc {sim.pc:#010x}")
+        print(f"Instructions: {retired}  Time: {seconds:.4f} s  MIPS: {mips:.3f}")
+    return 2 if result.reason is StopReason.TRAP else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
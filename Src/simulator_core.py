@@ -1,7 +1,18 @@
-import struct
+import enum
+import functools
+import mmap
+import os
 import sys
-import tkinter as tk
-from tkinter import ttk, filedialog, scrolledtext
+import tempfile
+import threading
+import time
+from array import array
+from collections import defaultdict, deque, namedtuple
+try:
+    import tkinter as tk
+    from tkinter import ttk, filedialog, scrolledtext, font as tkfont
+except ImportError:  # Python built without Tk: the engine still works headless.
+    tk = None
 
 # =============================================================================
 #  بخش ۱: هسته اصلی شبیه‌ساز (موتور)
@@ -34,116 +45,1711 @@ class Instruction:
         sign_bit = 1 << (bits - 1)
         return (value & (sign_bit - 1)) - (value & sign_bit)
 
+class PagedMemory:
+    """Sparse 32-bit guest address space made of 4 KiB pages.
+
+    Pages are allocated on the first write to them; reading untouched memory yields
+    zeros without allocating. Each page carries typed memoryview casts so aligned
+    8/16/32-bit accesses index straight into it, and the most recently read and written
+    pages are remembered so runs of accesses to the same page skip the page-table lookup.
+    Misaligned or page-crossing accesses take the generic load()/store() path.
+
+    fork() shares pages copy-on-write: only pages listed in _owned may be written in
+    place, and the first write to any other page copies it (a write fault).
+    """
+    PAGE_SHIFT = 12
+    PAGE_SIZE = 1 << PAGE_SHIFT
+    OFFSET_MASK = PAGE_SIZE - 1
+    ADDRESS_MASK = 0xFFFFFFFF
+
+    @staticmethod
+    def _make_views(page):
+        raw = memoryview(page)
+        # Indexed as views[0..4]: bytes, u16, s16, u32, s32.
+        return (raw, raw.cast('H'), raw.cast('h'), raw.cast('I'), raw.cast('i'))
+
+    _ZERO_VIEWS = _make_views(bytes(PAGE_SIZE))
+
+    def __init__(self):
+        self.pages = {}
+        self._views = {}
+        self._owned = set()
+        self._last_number, self._last_views = -1, None
+        self._last_write_number, self._last_write_views = -1, None
+        # Pages whose contents may have changed since the last take_dirty_pages(). A page
+        # is added when its views are fetched for writing, i.e. only on a write-cache miss.
+        self.dirty_pages = set()
+
+    def clear(self):
+        self.dirty_pages.update(self.pages)
+        self.pages.clear()
+        self._views.clear()
+        self._owned.clear()
+        self._last_number, self._last_views = -1, None
+        self._last_write_number, self._last_write_views = -1, None
+
+    def fork(self):
+        """Returns an independent copy of this memory that shares every page copy-on-write."""
+        child = PagedMemory()
+        child.share_pages(self)
+        return child
+
+    def share_pages(self, source):
+        """Replaces this memory's contents with copy-on-write shares of source's pages."""
+        self.clear()
+        self.pages.update(source.pages)
+        self._views.update(source._views)
+        self.dirty_pages.update(source.pages)
+        # Both sides now only read the shared pages; whichever writes one first copies it.
+        source._owned.clear()
+        source._last_write_number, source._last_write_views = -1, None
+
+    @property
+    def footprint(self):
+        """Bytes of host memory backing guest pages (pages shared with forks count in full)."""
+        return len(self.pages) * self.PAGE_SIZE
+
+    def _views_for_read(self, number):
+        views = self._views.get(number)
+        if views is None: return self._ZERO_VIEWS
+        self._last_number, self._last_views = number, views
+        return views
+
+    def _views_for_write(self, number):
+        views = self._views[number] if number in self._owned else self._write_fault(number)
+        self._last_write_number, self._last_write_views = number, views
+        self.dirty_pages.add(number)
+        return views
+
+    def take_dirty_pages(self):
+        """Returns the pages written since the previous call (page_view writes excepted).
+
+        Also forgets the cached write page, so the next write to it is marked again.
+        """
+        dirty, self.dirty_pages = self.dirty_pages, set()
+        self._last_write_number, self._last_write_views = -1, None
+        return dirty
+
+    def _write_fault(self, number):
+        # First write to a page: allocate it, or take a private copy if it is shared.
+        shared = self.pages.get(number)
+        page = self.pages[number] = bytearray(self.PAGE_SIZE) if shared is None else bytearray(shared)
+        views = self._views[number] = self._make_views(page)
+        self._owned.add(number)
+        if number == self._last_number: self._last_views = views
+        return views
+
+    def nonzero_pages(self):
+        """Yields (page number, page) for allocated pages that hold any non-zero byte, in address order."""
+        zero = self._ZERO_VIEWS[0]
+        for number in sorted(self.pages):
+            page = self.pages[number]
+            if page != zero: yield number, page
+
+    def adopt_page(self, number, page):
+        """Installs a writable PAGE_SIZE buffer (bytearray, mmap slice, ...) as page number, without copying."""
+        self.pages[number] = page
+        views = self._views[number] = self._make_views(page)
+        self._owned.add(number)
+        self.dirty_pages.add(number)
+        if number == self._last_number: self._last_views = views
+        if number == self._last_write_number: self._last_write_views = views
+
+    def page_view(self, address):
+        """Zero-copy, writable view of the page holding address (allocating it).
+
+        The view stays bound to that page: after a fork() writes through it reach both copies.
+        """
+        return self._views_for_write((address & self.ADDRESS_MASK) >> self.PAGE_SHIFT)[0]
+
+    # --- Aligned fast paths ---
+
+    def load_byte(self, address):
+        address &= 0xFFFFFFFF
+        number = address >> 12
+        views = self._last_views if number == self._last_number else self._views_for_read(number)
+        return views[0][address & 0xFFF]
+
+    def load_byte_signed(self, address):
+        return (self.load_byte(address) ^ 0x80) - 0x80
+
+    def load_half(self, address):
+        address &= 0xFFFFFFFF
+        if address & 1: return self.load(address, 2)
+        number = address >> 12
+        views = self._last_views if number == self._last_number else self._views_for_read(number)
+        return views[1][(address & 0xFFF) >> 1]
+
+    def load_half_signed(self, address):
+        address &= 0xFFFFFFFF
+        if address & 1: return self.load(address, 2, True)
+        number = address >> 12
+        views = self._last_views if number == self._last_number else self._views_for_read(number)
+        return views[2][(address & 0xFFF) >> 1]
+
+    def load_word(self, address):
+        address &= 0xFFFFFFFF
+        if address & 3: return self.load(address, 4)
+        number = address >> 12
+        views = self._last_views if number == self._last_number else self._views_for_read(number)
+        return views[3][(address & 0xFFF) >> 2]
+
+    def load_word_signed(self, address):
+        address &= 0xFFFFFFFF
+        if address & 3: return self.load(address, 4, True)
+        number = address >> 12
+        views = self._last_views if number == self._last_number else self._views_for_read(number)
+        return views[4][(address & 0xFFF) >> 2]
+
+    def store_byte(self, address, value):
+        address &= 0xFFFFFFFF
+        number = address >> 12
+        views = self._last_write_views if number == self._last_write_number else self._views_for_write(number)
+        views[0][address & 0xFFF] = value & 0xFF
+
+    def store_half(self, address, value):
+        address &= 0xFFFFFFFF
+        if address & 1: return self.store(address, 2, value)
+        number = address >> 12
+        views = self._last_write_views if number == self._last_write_number else self._views_for_write(number)
+        views[1][(address & 0xFFF) >> 1] = value & 0xFFFF
+
+    def store_word(self, address, value):
+        address &= 0xFFFFFFFF
+        if address & 3: return self.store(address, 4, value)
+        number = address >> 12
+        views = self._last_write_views if number == self._last_write_number else self._views_for_write(number)
+        views[3][(address & 0xFFF) >> 2] = value & 0xFFFFFFFF
+
+    if sys.byteorder != 'little':
+        # Typed views use host byte order; big-endian hosts go through the generic paths.
+        def load_byte(self, address): return self.load(address, 1)
+        def load_half(self, address): return self.load(address, 2)
+        def load_half_signed(self, address): return self.load(address, 2, True)
+        def load_word(self, address): return self.load(address, 4)
+        def load_word_signed(self, address): return self.load(address, 4, True)
+        def store_byte(self, address, value): self.store(address, 1, value)
+        def store_half(self, address, value): self.store(address, 2, value)
+        def store_word(self, address, value): self.store(address, 4, value)
+
+    # --- Generic paths (any size, alignment, page crossing) ---
+
+    def load(self, address, size, signed=False):
+        return int.from_bytes(self.read(address, size), 'little', signed=signed)
+
+    def store(self, address, size, value):
+        self.write(address, (value & ((1 << (8 * size)) - 1)).to_bytes(size, 'little'))
+
+    def read(self, address, size):
+        """Copies size bytes starting at address (wrapping at 4 GiB)."""
+        out = bytearray()
+        while size > 0:
+            address &= self.ADDRESS_MASK
+            offset = address & self.OFFSET_MASK
+            chunk = min(size, self.PAGE_SIZE - offset)
+            out += self._views.get(address >> self.PAGE_SHIFT, self._ZERO_VIEWS)[0][offset:offset + chunk]
+            address, size = address + chunk, size - chunk
+        return bytes(out)
+
+    def write(self, address, data):
+        """Copies data into guest memory starting at address (wrapping at 4 GiB)."""
+        data = memoryview(data).cast('B')
+        while data:
+            address &= self.ADDRESS_MASK
+            offset = address & self.OFFSET_MASK
+            chunk = min(len(data), self.PAGE_SIZE - offset)
+            self._views_for_write(address >> self.PAGE_SHIFT)[0][offset:offset + chunk] = data[:chunk]
+            address, data = address + chunk, data[chunk:]
+
+    # Slicing keeps the old bytearray-style access (memory[a:b], memory[a:b] = data).
+    def __getitem__(self, key):
+        if isinstance(key, slice):
+            return self.read(key.start, max(0, key.stop - key.start))
+        return self.load_byte(key)
+
+    def __setitem__(self, key, data):
+        if isinstance(key, slice):
+            self.write(key.start, data)
+        else:
+            self.store_byte(key, data)
+
+ABI_NAMES = ('zero', 'ra', 'sp', 'gp', 'tp', 't0', 't1', 't2', 's0', 's1', 'a0', 'a1', 'a2', 'a3', 'a4', 'a5',
+             'a6', 'a7', 's2', 's3', 's4', 's5', 's6', 's7', 's8', 's9', 's10', 's11', 't3', 't4', 't5', 't6')
+
+def register_changes(before, after):
+    """Bitmask with bit i set where x<i> differs between two register snapshots."""
+    mask = 0
+    for i in range(32):
+        if before[i] != after[i]: mask |= 1 << i
+    return mask
+
+def hexdump_lines(memory, start, length):
+    """Yields `addr: hex bytes |ascii|` lines, 16 bytes each, for length bytes of memory from start."""
+    for addr in range(start, start + length, 16):
+        data_chunk = memory[addr:min(addr + 16, start + length)]
+        hex_repr = ' '.join(f'{b:02x}' for b in data_chunk)
+        ascii_repr = ''.join(chr(b) if 32 <= b <= 126 else '.' for b in data_chunk)
+        yield f"{addr:#06x}: {hex_repr:<48} |{ascii_repr}|"
+
+class StopReason(enum.Enum):
+    BUDGET = 'budget'            # max_instructions retired
+    STOP_PC = 'stop_pc'          # pc reached one of the requested stop addresses
+    HALTED = 'halted'            # zero word or end of memory
+    HALTED_IDLE = 'halted_idle'  # branch/jump to itself that can never change state
+    TRAP = 'trap'                # undecodable instruction
+
+RunResult = namedtuple('RunResult', ['reason', 'instructions', 'pc'])
+
+class TranslatedBlock:
+    """A straight-line run of guest instructions compiled into one Python function.
+
+    fn(r) returns the successor TranslatedBlock (None on halt, with sim.pc set).
+    links[0]/links[1] chain the fall-through/taken exits once resolved, and
+    jalr_cache holds the two most recent (target, block) pairs of a jalr exit.
+    """
+    __slots__ = ('start', 'end', 'length', 'fn', 'source', 'links', 'jalr_cache')
+
+    def __init__(self, start, end, length, source):
+        self.start = start
+        self.end = end
+        self.length = length
+        self.fn = None
+        self.source = source
+        self.links = [None, None]
+        self.jalr_cache = [None, None, None, None]
+
+    def unlink(self):
+        self.links[:] = [None, None]
+        self.jalr_cache[:] = [None, None, None, None]
+
+class ExecutionHistory:
+    """Bounded record of recent execution, for stepping backwards.
+
+    Each retired instruction appends an undo record to a ring buffer of `capacity`
+    entries, kept as parallel arrays: its pc, the register it wrote (0 for none) with the
+    old value, and for stores the address, size and old bytes. Every
+    `checkpoint_interval` instructions a copy-on-write checkpoint of the whole state is
+    kept as well (at most `max_checkpoints` of them), so positions older than the ring are
+    reached by restoring a checkpoint and executing forward again.
+
+    With `recording` off, run() uses the selected engine and keeps only the checkpoints;
+    stepping back into such a stretch re-executes it from the checkpoint before it.
+    """
+    def __init__(self, capacity=1 << 16, checkpoint_interval=1 << 16, max_checkpoints=16):
+        self.capacity = capacity
+        self.checkpoint_interval = checkpoint_interval
+        self.pcs = array('I', bytes(4 * capacity))
+        self.rds = bytearray(capacity)
+        self.old_values = array('I', bytes(4 * capacity))
+        self.addresses = array('I', bytes(4 * capacity))
+        self.sizes = bytearray(capacity)
+        self.old_bytes = array('I', bytes(4 * capacity))
+        self.recording = True
+        # (position, pc, registers, memory) tuples, oldest first.
+        self.checkpoints = deque(maxlen=max_checkpoints)
+        self.clear()
+
+    def clear(self):
+        self.position = 0        # instructions recorded since the history started
+        self.oldest = 0          # oldest position the ring can still undo to
+        self.next_checkpoint = 0
+        self.checkpoints.clear()
+
+class Profile:
+    """Execution counts gathered while profiling is enabled.
+
+    Instructions that are interpreted one at a time bump pc_counts[pc]. Translated blocks
+    built while profiling count entries instead, one list increment per block:
+    block_hits[i] is the number of times the block covering block_spans[i] = (start, end)
+    ran. instruction_counts() merges both into per-pc totals.
+    """
+    def __init__(self):
+        self.pc_counts = defaultdict(int)
+        self.block_spans = []
+        self.block_hits = []
+
+    def add_block(self, start, end):
+        """Registers a translated block; returns the block_hits index its code increments."""
+        self.block_spans.append((start, end))
+        self.block_hits.append(0)
+        return len(self.block_hits) - 1
+
+    def instruction_counts(self):
+        counts = defaultdict(int, self.pc_counts)
+        for (start, end), hits in zip(self.block_spans, self.block_hits):
+            if hits:
+                for pc in range(start, end, 4):
+                    counts[pc] += hits
+        return counts
+
+    def basic_blocks(self, decode_cache):
+        """[(start, end, entries)] for the straight-line runs of executed code, in address order.
+
+        A run is split after a branch/jump, at a gap and wherever the count changes (the
+        later instruction was also entered from elsewhere).
+        """
+        counts = self.instruction_counts()
+        blocks = []
+        for pc in sorted(counts):
+            previous = decode_cache.get(pc - 4)
+            if (blocks and blocks[-1][1] == pc and counts[pc - 4] == counts[pc]
+                    and previous is not None and previous[0] not in RISCVSimulator._TERMINATOR_OPS):
+                blocks[-1][1] = pc + 4
+            else:
+                blocks.append([pc, pc + 4, counts[pc]])
+        return [tuple(block) for block in blocks]
+
+class Statistics:
+    """Dynamic instruction statistics, collected on every engine at all times.
+
+    The 'interp' engine only counts where straight-line runs end: each taken branch or
+    jump bumps run_ends[its pc], and a jalr also bumps run_starts[target] (other runs
+    start at a target that can be read back from the decoded instruction). flush_runs()
+    turns these into op_counts[handler] when the run() call ends or when a store
+    rewrites cached code; the latter closes the open run at the store and reopens it
+    after, so no pc is decoded again once its instruction changed. The recording and
+    single-step paths bump op_counts (and taken, for a taken branch) directly.
+
+    Translated blocks count in batches too, with one increment per entry into their
+    own [fall-through exits, taken exits] counter: a block ending in a branch indexes it
+    with the branch condition, any other block bumps slot 0. The counters are kept in
+    blocks next to each block's static handler list in block_ops, and summary()
+    multiplies the two out.
+    """
+    def __init__(self):
+        self.op_counts = defaultdict(int)
+        self.taken = 0
+        self.run_starts = defaultdict(int)
+        self.run_ends = defaultdict(int)
+        self.block_ops = []
+        self.blocks = []
+
+    def flush_runs(self, sim, tail=None):
+        """Folds the pending run starts/ends into op_counts using sim's decoded instructions.
+
+        tail is the last pc executed by an unfinished run (pc - 4 when the run was cut off
+        at pc, which also closes a run that started at pc but never executed).
+        """
+        branches, jalr = RISCVSimulator._BRANCH_CONDITIONS, RISCVSimulator._op_jalr
+        decode = lambda pc: sim.decode_cache.get(pc) or sim._decode(pc)
+        # Instruction x ran (runs started at or before x) - (runs ended before x) times;
+        # runs never change pc modulo 4, so each alignment is swept separately.
+        deltas = defaultdict(int, self.run_starts)
+        for pc, count in self.run_ends.items():
+            deltas[pc + 4] -= count
+            entry = decode(pc)
+            handler, imm = entry[0], entry[4]
+            if handler is not jalr: deltas[(pc + imm) & 0xFFFFFFFF] += count
+            if handler in branches: self.taken += count
+        if tail is not None: deltas[tail + 4] -= 1
+        op_counts, running = self.op_counts, 0
+        points = sorted(deltas, key=lambda pc: (pc & 3, pc))
+        for here, following in zip(points, points[1:] + [None]):
+            running += deltas[here]
+            if running and following is not None and following & 3 == here & 3:
+                for pc in range(here, following, 4):
+                    op_counts[decode(pc)[0]] += running
+        self.run_starts.clear()
+        self.run_ends.clear()
+
+    def add_block(self, handlers):
+        """Registers a translated block's handlers; returns the counter list its code increments."""
+        counter = [0, 0]
+        self.block_ops.append(handlers)
+        self.blocks.append(counter)
+        return counter
+
+    def summary(self):
+        """Totals as a JSON-ready dict: instructions, per-class and per-mnemonic counts, memory traffic."""
+        counts, taken = defaultdict(int, self.op_counts), self.taken
+        for handlers, (fallen, block_taken) in zip(self.block_ops, self.blocks):
+            entries = fallen + block_taken
+            if entries:
+                for handler in handlers:
+                    counts[handler] += entries
+                taken += block_taken
+        classes = dict.fromkeys(('alu', 'muldiv', 'load', 'store', 'branch_taken', 'branch_not_taken', 'jump'), 0)
+        bytes_read = bytes_written = 0
+        for handler, count in counts.items():
+            kind = RISCVSimulator._OP_CLASSES[handler]
+            classes['branch_not_taken' if kind == 'branch' else kind] += count
+            bytes_read += RISCVSimulator.LOAD_SIZES.get(handler, 0) * count
+            bytes_written += RISCVSimulator.STORE_SIZES.get(handler, 0) * count
+        classes['branch_taken'] = taken
+        classes['branch_not_taken'] -= taken
+        instructions = sum(counts.values())
+        # A basic block ends at each branch or jump executed.
+        transfers = classes['branch_taken'] + classes['branch_not_taken'] + classes['jump']
+        mnemonics = RISCVSimulator.MNEMONICS
+        return {'instructions': instructions, 'classes': classes,
+                'bytes_read': bytes_read, 'bytes_written': bytes_written,
+                'average_block_length': instructions / transfers if transfers else float(instructions),
+                'mnemonics': dict(sorted(((mnemonics[h], c) for h, c in counts.items()), key=lambda item: -item[1]))}
+
+class CallStackSampler:
+    """Shadow call stack, sampled every `period` retired instructions.
+
+    A jal/jalr that links through ra is a call and pushes (target, return address). A
+    jalr x0 through ra is a return: it unwinds to the frame whose return address it jumps
+    to, and is ignored if no frame matches (returns out of code entered before sampling
+    began, longjmp-style jumps). samples counts each observed stack as a tuple of entry
+    pcs, outermost first, rooted at the pc sampling started from.
+    """
+    def __init__(self, root, period=1000, max_depth=1024):
+        self.root = root
+        self.period = period
+        self.max_depth = max_depth
+        self.frames = []  # [(entry pc, return address)]
+        self.countdown = period
+        self.samples = defaultdict(int)
+
+    def call(self, target, return_address):
+        frames = self.frames
+        if len(frames) >= self.max_depth: del frames[0]
+        frames.append((target, return_address))
+
+    def ret(self, target):
+        frames = self.frames
+        for depth in range(len(frames) - 1, -1, -1):
+            if frames[depth][1] == target:
+                del frames[depth:]
+                return
+
+    def sample(self):
+        self.samples[(self.root,) + tuple(entry for entry, _ in self.frames)] += 1
+        self.countdown = self.period
+
+    def folded(self, name=hex):
+        """Folded-stack lines ('outer;inner count') as read by flame-graph tools.
+
+        name turns an entry pc into a frame name; stacks that end up with the same
+        names are merged.
+        """
+        merged = defaultdict(int)
+        for stack, count in self.samples.items():
+            merged[';'.join(name(pc) for pc in stack)] += count
+        return [f"{stack} {count}" for stack, count in sorted(merged.items())]
+
+# Operand layout of each instruction format: how decoding picks the immediate handed to
+# the handler and how the disassembler prints the operands.
+_FORMATS = {
+    'R': (lambda instr: 0, "{rd}, {rs1}, {rs2}"),
+    'I': (lambda instr: instr.imm_I, "{rd}, {rs1}, {imm}"),
+    'SH': (lambda instr: instr.rs2, "{rd}, {rs1}, {imm}"),
+    'L': (lambda instr: instr.imm_I, "{rd}, {imm}({rs1})"),
+    'S': (lambda instr: instr.imm_S, "{rs2}, {imm}({rs1})"),
+    'B': (lambda instr: instr.imm_B, "{rs1}, {rs2}, {target}"),
+    'U': (lambda instr: instr.imm_U & 0xFFFFFFFF, "{rd}, {upper:#x}"),
+    'J': (lambda instr: instr.imm_J, "{rd}, {target}"),
+    'JR': (lambda instr: instr.imm_I, "{rd}, {imm}({rs1})"),
+}
+
+OpSpec = namedtuple('OpSpec', ['mnemonic', 'format', 'handler'])
+
+def _dispatch_key(word):
+    """17-bit dispatch index of an instruction word: opcode | funct3 << 7 | funct7 << 10."""
+    return (word & 0x7F) | ((word >> 5) & 0x380) | ((word >> 15) & 0x1FC00)
+
+def _build_dispatch(instruction_set):
+    # Fields that hold immediate bits (None in the instruction set) get every value, so
+    # decoding is one lookup whatever the format.
+    table = {}
+    for mnemonic, fmt, opcode, funct3, funct7, handler in instruction_set:
+        spec = OpSpec(mnemonic, fmt, handler)
+        for f3 in range(8) if funct3 is None else (funct3,):
+            for f7 in range(128) if funct7 is None else (funct7,):
+                table[opcode | f3 << 7 | f7 << 10] = spec
+    return table
+
+# RV32M division on signed operands, returning the unsigned 32-bit result. The quotient
+# truncates toward zero and the remainder takes the dividend's sign; dividing by zero
+# gives all ones / the dividend, and -2**31 / -1 wraps back to -2**31 with remainder 0.
+def _div32(a, b):
+    if b == 0: return 0xFFFFFFFF
+    q = abs(a) // abs(b)
+    return (q if (a < 0) == (b < 0) else -q) & 0xFFFFFFFF
+
+def _rem32(a, b):
+    if b == 0: return a & 0xFFFFFFFF
+    r = abs(a) % abs(b)
+    return (r if a >= 0 else -r) & 0xFFFFFFFF
+
 class RISCVSimulator:
-    def __init__(self, mem_size=64 * 1024):
-        self.mem_size = mem_size
-        self.memory = bytearray(mem_size)
-        self.registers = [0] * 32
+    MAX_BLOCK_LENGTH = 64
+    JIT_THRESHOLD = 32
+    # 'interp' runs predecoded instructions one at a time; 'block' runs chained translated
+    # blocks; 'jit' interprets cold code and translates blocks once they turn hot.
+    ENGINES = ('interp', 'block', 'jit')
+
+    def __init__(self, engine='block'):
+        if engine not in self.ENGINES:
+            raise ValueError(f"Unknown engine '{engine}' (expected one of {', '.join(self.ENGINES)}).")
+        self.engine = engine
+        self.memory = PagedMemory()
+        # x0..x31 as canonical unsigned 32-bit values in one fixed buffer; every handler
+        # wraps its result, so the array's range check doubles as an invariant check.
+        # signed_registers aliases the same bytes as two's-complement ints.
+        self.registers = array('I', [0] * 32)
+        self.signed_registers = memoryview(self.registers).cast('B').cast('i')
         self.pc = 0x1000
         self.running = False
+        # pc -> (handler, rd, rs1, rs2, imm); words holding cached code are tracked
+        # in _code_words (address >> 2) so stores can invalidate exactly what they hit.
+        self.decode_cache = {}
+        self.block_cache = {}
+        self._block_heat = {}
+        self._code_words = set()
+        self._idle = False
+        self.history = None
+        self.profile = None
+        self.sampler = None
+        self.tracer = None
+        self.stats = Statistics()
 
     def load_program(self, filename):
-        self.reset()
         try:
             with open(filename, 'rb') as f:
                 program_bytes = f.read()
-            self.memory[0x1000:0x1000 + len(program_bytes)] = program_bytes
+            self.load_image(program_bytes)
             return f"Program '{filename}' loaded ({len(program_bytes)} bytes)."
         except FileNotFoundError:
             return f"Error: File '{filename}' not found."
 
+    def load_image(self, program_bytes):
+        """Resets the simulator and places program_bytes at 0x1000 (the assembler's origin)."""
+        self.reset()
+        self.memory.write(0x1000, program_bytes)
+
+    # --- Snapshots ---
+    # Little-endian file layout: magic, then u32 version, page count and pc, the 32
+    # registers, and the page numbers; page contents follow, starting on the next 4 KiB
+    # boundary, in the order their numbers were listed. Only pages holding non-zero data
+    # are stored. The simulator has no device state yet.
+    SNAPSHOT_MAGIC = b'RVSNAP\0\0'
+    SNAPSHOT_VERSION = 1
+    _SNAPSHOT_HEADER = len(SNAPSHOT_MAGIC) + 4 * (3 + 32)
+
+    def save_snapshot(self, filename):
+        """Writes pc, registers and non-zero memory pages to filename.
+
+        The file is written under a temporary name and then renamed over filename, so a
+        snapshot this simulator (or another) has mapped is never rewritten in place.
+        """
+        pages = list(self.memory.nonzero_pages())
+        header = array('I', [self.SNAPSHOT_VERSION, len(pages), self.pc])
+        header.extend(self.registers)
+        header.extend(number for number, _ in pages)
+        if sys.byteorder != 'little': header.byteswap()
+        header = self.SNAPSHOT_MAGIC + header.tobytes()
+        descriptor, temporary = tempfile.mkstemp(dir=os.path.dirname(os.path.abspath(filename)), prefix='.snapshot-')
+        try:
+            with os.fdopen(descriptor, 'wb') as f:
+                f.write(header)
+                f.write(bytes(-len(header) % PagedMemory.PAGE_SIZE))
+                for _, page in pages:
+                    f.write(page)
+            os.replace(temporary, filename)
+        except BaseException:
+            os.unlink(temporary)
+            raise
+        return f"Snapshot '{filename}' saved ({len(pages)} pages)."
+
+    def load_snapshot(self, filename, use_mmap=True):
+        """Restores pc, registers and memory from save_snapshot() output.
+
+        With use_mmap the pages stay in a private copy-on-write mapping of the file, so
+        restoring costs nothing for pages the program never touches again. The file must
+        then not be changed in place while this simulator runs (reading a page that was
+        truncated away raises SIGBUS); save_snapshot() replaces files instead.
+        """
+        try:
+            f = open(filename, 'rb')
+        except FileNotFoundError:
+            return f"Error: File '{filename}' not found."
+        with f:
+            head = f.read(self._SNAPSHOT_HEADER)
+            if len(head) < self._SNAPSHOT_HEADER or not head.startswith(self.SNAPSHOT_MAGIC):
+                return f"Error: '{filename}' is not a simulator snapshot."
+            fields = array('I', head[len(self.SNAPSHOT_MAGIC):])
+            if sys.byteorder != 'little': fields.byteswap()
+            version, count, pc = fields[:3]
+            if version != self.SNAPSHOT_VERSION:
+                return f"Error: Snapshot '{filename}' has unsupported version {version}."
+            numbers = array('I', f.read(4 * count))
+            if sys.byteorder != 'little': numbers.byteswap()
+            size = PagedMemory.PAGE_SIZE
+            data_offset = self._SNAPSHOT_HEADER + 4 * count
+            data_offset += -data_offset % size
+            if len(numbers) != count or f.seek(0, 2) < data_offset + count * size:
+                return f"Error: Snapshot '{filename}' is truncated."
+
+            self.reset()
+            self.pc = pc
+            self.registers[:] = fields[3:]
+            if count and use_mmap:
+                data = memoryview(mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_COPY))
+                for i, number in enumerate(numbers):
+                    self.memory.adopt_page(number, data[data_offset + i * size:data_offset + (i + 1) * size])
+            elif count:
+                f.seek(data_offset)
+                for number in numbers:
+                    self.memory.adopt_page(number, bytearray(f.read(size)))
+        return f"Snapshot '{filename}' loaded ({count} pages)."
+
+    def fork(self):
+        """Returns an independent simulator in the same state, sharing memory pages copy-on-write.
+
+        Predecoded instructions carry over; translated blocks are bound to the simulator
+        that built them, so the fork translates its own as it runs.
+        """
+        child = type(self)(engine=self.engine)
+        child.memory = self.memory.fork()
+        child.registers[:] = self.registers
+        child.pc = self.pc
+        child.decode_cache.update(self.decode_cache)
+        child._code_words.update(self._code_words)
+        return child
+
     def reset(self):
-        self.memory = bytearray(self.mem_size)
-        self.registers = [0] * 32
+        self.memory.clear()
+        self.registers[:] = array('I', [0] * 32)
         self.pc = 0x1000
         self.running = False
+        self.invalidate_decode_cache()
+        if self.history is not None: self.history.clear()
+        if self.sampler is not None: self.sampler.frames.clear()
+        if self.profile is not None: self.profile = Profile()
+        self.stats = Statistics()
 
-    def _get_signed_reg(self, reg_index):
-        return struct.unpack('<i', struct.pack('<I', self.registers[reg_index]))[0]
+    def invalidate_decode_cache(self):
+        """Drops all predecoded instructions and translated blocks (call after writing self.memory directly)."""
+        self.decode_cache.clear()
+        self.block_cache.clear()
+        self._block_heat.clear()
+        self._code_words.clear()
 
-    def run_single_step(self):
-        if self.pc >= self.mem_size: return False
-        instruction_bytes = self.memory[self.pc:self.pc + 4]
-        if len(instruction_bytes) < 4: return False
-        instruction_hex = struct.unpack('<I', instruction_bytes)[0]
-        if instruction_hex == 0: return False
-
-        instr = Instruction(instruction_hex)
-        next_pc = self.pc + 4
-        
-        opcode = instr.opcode
-        if opcode == 0x33:
-            rs1_val = self._get_signed_reg(instr.rs1)
-            rs2_val = self._get_signed_reg(instr.rs2)
-            if instr.funct3 == 0x0:
-                if instr.funct7 == 0x00: self.registers[instr.rd] = rs1_val + rs2_val # add
-                elif instr.funct7 == 0x20: self.registers[instr.rd] = rs1_val - rs2_val # sub
-            elif instr.funct3 == 0x4: self.registers[instr.rd] = rs1_val ^ rs2_val # xor
-            elif instr.funct3 == 0x6: self.registers[instr.rd] = rs1_val | rs2_val # or
-            elif instr.funct3 == 0x7: self.registers[instr.rd] = rs1_val & rs2_val # and
-            elif instr.funct3 == 0x1: self.registers[instr.rd] = rs1_val << (rs2_val & 0x1F) # sll
-            elif instr.funct3 == 0x5:
-                if instr.funct7 == 0x00: self.registers[instr.rd] = self.registers[instr.rs1] >> (rs2_val & 0x1F) # srl
-                elif instr.funct7 == 0x20: self.registers[instr.rd] = rs1_val >> (rs2_val & 0x1F) # sra
-            elif instr.funct3 == 0x2: self.registers[instr.rd] = 1 if rs1_val < rs2_val else 0 # slt
-            elif instr.funct3 == 0x3: self.registers[instr.rd] = 1 if self.registers[instr.rs1] < self.registers[instr.rs2] else 0 # sltu
-            if instr.funct7 == 0x01:
-                if instr.funct3 == 0x0: self.registers[instr.rd] = rs1_val * rs2_val # mul
-                elif instr.funct3 == 0x1: self.registers[instr.rd] = (rs1_val * rs2_val) >> 32 # mulh
-                elif instr.funct3 == 0x4: self.registers[instr.rd] = -1 if rs2_val == 0 else int(rs1_val / rs2_val) # div
-                elif instr.funct3 == 0x6: self.registers[instr.rd] = rs1_val if rs2_val == 0 else rs1_val % rs2_val # rem
-        elif opcode == 0x13: # addi
-            self.registers[instr.rd] = self.registers[instr.rs1] + instr.imm_I
-        elif opcode == 0x03:
-            address = self.registers[instr.rs1] + instr.imm_I
-            if instr.funct3 == 0x2: # lw
-                self.registers[instr.rd] = struct.unpack('<i', self.memory[address:address+4])[0]
-            elif instr.funct3 == 0x1: # lh
-                self.registers[instr.rd] = struct.unpack('<h', self.memory[address:address+2])[0]
-        elif opcode == 0x23:
-            address = self.registers[instr.rs1] + instr.imm_S
-            if instr.funct3 == 0x2: # sw
-                self.memory[address:address+4] = struct.pack('<i', self.registers[instr.rs2])
-            elif instr.funct3 == 0x1: # sh
-                self.memory[address:address+2] = struct.pack('<h', self.registers[instr.rs2] & 0xFFFF)
-        elif opcode == 0x63:
-            rs1_val, rs2_val = self._get_signed_reg(instr.rs1), self._get_signed_reg(instr.rs2)
-            condition_met = False
-            if instr.funct3 == 0x0 and rs1_val == rs2_val: condition_met = True  # beq
-            elif instr.funct3 == 0x1 and rs1_val != rs2_val: condition_met = True # bne
-            elif instr.funct3 == 0x4 and rs1_val < rs2_val: condition_met = True  # blt
-            elif instr.funct3 == 0x5 and rs1_val >= rs2_val: condition_met = True # bge
-            elif instr.funct3 == 0x6 and self.registers[instr.rs1] < self.registers[instr.rs2]: condition_met = True # bltu
-            elif instr.funct3 == 0x7 and self.registers[instr.rs1] >= self.registers[instr.rs2]: condition_met = True # bgeu
-            if condition_met: next_pc = self.pc + instr.imm_B
-        elif opcode == 0x37: self.registers[instr.rd] = instr.imm_U # lui
-        elif opcode == 0x17: self.registers[instr.rd] = self.pc + instr.imm_U # auipc
-        elif opcode == 0x6F: # jal
-            self.registers[instr.rd] = self.pc + 4
-            next_pc = self.pc + instr.imm_J
-        elif opcode == 0x67: # jalr
-            self.registers[instr.rd] = self.pc + 4
-            next_pc = (self.registers[instr.rs1] + instr.imm_I) & ~1
-        else: return False
+    def register_snapshot(self):
+        """Returns a copy of x0..x31 taken with a single buffer copy."""
+        return self.registers[:]
+
+    def _decode(self, pc):
+        if not 0 <= pc <= 0xFFFFFFFC: return None
+        entry = self.decode_word(self.memory.load_word(pc))
+        if entry is None: return None
+        self.decode_cache[pc] = entry
+        self._code_words.add(pc >> 2)
+        self._code_words.add((pc + 3) >> 2)
+        return entry
+
+    @classmethod
+    def decode_word(cls, word):
+        """Decodes one instruction word to (handler, rd, rs1, rs2, imm), or None if it is not one."""
+        spec = cls._DISPATCH.get(_dispatch_key(word)) if word else None
+        if spec is None: return None
+        instr = Instruction(word)
+        return spec.handler, instr.rd, instr.rs1, instr.rs2, _FORMATS[spec.format][0](instr)
+
+    @classmethod
+    def disassemble_word(cls, word, pc=None):
+        """Renders one instruction word as assembly; branch/jump targets are absolute when pc is given."""
+        spec = cls._DISPATCH.get(_dispatch_key(word)) if word else None
+        if spec is None: return f".word {word:#010x}"
+        instr = Instruction(word)
+        immediate, operands = _FORMATS[spec.format]
+        imm = immediate(instr)
+        target = f"{(pc + imm) & 0xFFFFFFFF:#x}" if pc is not None else f"{imm:+d}"
+        return f"{spec.mnemonic} " + operands.format(rd=f"x{instr.rd}", rs1=f"x{instr.rs1}", rs2=f"x{instr.rs2}",
+                                                      imm=imm, target=target, upper=imm >> 12)
+
+    def disassemble(self, pc):
+        """Disassembles the instruction currently in memory at pc."""
+        return self.disassemble_word(self.memory.load_word(pc), pc)
+
+    def _invalidate_code(self, address, size, pc=None):
+        code_words = self._code_words
+        if (address >> 2) in code_words or ((address + size - 1) >> 2) in code_words:
+            stats = self.stats
+            if pc is not None and (stats.run_starts or stats.run_ends):
+                # A store from the interpreter: count its open run up to and including the
+                # store while the old code is still decoded, then reopen the run after it.
+                stats.flush_runs(self, pc)
+                stats.run_starts[pc + 4] += 1
+            for pc in range(address - 3, address + size):
+                self.decode_cache.pop(pc, None)
+            stale = [start for start, block in self.block_cache.items()
+                     if block.start < address + size and address < block.end]
+            if stale:
+                for start in stale:
+                    del self.block_cache[start]
+                # Chained exits may point at a dropped block; let them re-resolve.
+                for block in self.block_cache.values():
+                    block.unlink()
 
+    def run_single_step(self):
+        pc = self.pc
+        entry = self.decode_cache.get(pc)
+        if entry is None:
+            entry = self._decode(pc)
+            if entry is None: return False
+        handler, rd, rs1, rs2, imm = entry
+        self.stats.op_counts[handler] += 1
+        next_pc = handler(self, pc, rd, rs1, rs2, imm)
+        if next_pc != pc + 4 and handler in self._BRANCH_CONDITIONS: self.stats.taken += 1
         self.registers[0] = 0
         self.pc = next_pc
         return True
 
+    def run(self, max_instructions, stop_pcs=()):
+        """Executes up to max_instructions with the selected engine.
+
+        Stops early when the pc reaches one of stop_pcs (after at least one instruction),
+        on a zero word / the end of memory (HALTED), on an idle self-loop such as
+        `halt: jal x0, halt` (HALTED_IDLE) or on an undecodable instruction (TRAP).
+        Returns a RunResult(reason, instructions, pc).
+
+        While history is recording every engine runs as the recording interpreter; with
+        history.recording off the selected engine runs and only checkpoints are taken.
+        While tracing, every engine runs as the tracing interpreter (and history is not
+        recorded).
+        """
+        stop_pcs = frozenset(stop_pcs)
+        if max_instructions <= 0:
+            return RunResult(StopReason.BUDGET, 0, self.pc)
+        self._idle = False
+        if self.sampler is not None:
+            retired, reason = self._run_sampled(max_instructions, stop_pcs)
+        else:
+            retired, reason = self._run_engine(max_instructions, stop_pcs)
+        if reason is None or reason is StopReason.HALTED:
+            reason = self._halt_reason()
+        return RunResult(reason, retired, self.pc)
+
+    def _run_engine(self, max_instructions, stop_pcs):
+        if self.tracer is not None:
+            retired, reason = self._run_tracing(max_instructions, stop_pcs)
+        elif self.history is not None:
+            if self.history.recording:
+                retired, reason = self._run_recording(max_instructions, stop_pcs)
+            else:
+                retired, reason = self._run_checkpointed(max_instructions, stop_pcs)
+        else:
+            retired, reason = self._run_selected(max_instructions, stop_pcs)
+        return retired, reason
+
+    def _run_selected(self, max_instructions, stop_pcs):
+        if self.engine == 'block':
+            retired, reason = self._run_chain(self._lookup_block(self.pc), max_instructions, stop_pcs)
+        elif self.engine == 'jit':
+            retired, reason = self._run_tiered(max_instructions, stop_pcs)
+        else:
+            retired, reason = self._run_interp(max_instructions, stop_pcs)
+        return retired, reason
+
+    def _run_interp(self, max_instructions, stop_pcs):
+        retired, reason = 0, StopReason.BUDGET
+        registers, decode_cache = self.registers, self.decode_cache
+        pc_counts = self.profile.pc_counts if self.profile is not None else None
+        stats, jalr = self.stats, type(self)._op_jalr
+        ends, starts = stats.run_ends, stats.run_starts
+        pc = self.pc
+        starts[pc] += 1
+        while retired < max_instructions:
+            entry = decode_cache.get(pc)
+            if entry is None:
+                entry = self._decode(pc)
+                if entry is None:
+                    reason = StopReason.HALTED
+                    break
+            if pc_counts is not None: pc_counts[pc] += 1
+            handler, rd, rs1, rs2, imm = entry
+            next_pc = handler(self, pc, rd, rs1, rs2, imm)
+            registers[0] = 0
+            retired += 1
+            if next_pc != pc + 4:
+                ends[pc] += 1
+                if handler is jalr: starts[next_pc] += 1
+                if next_pc == pc and self._is_idle_loop(entry):
+                    reason = StopReason.HALTED_IDLE
+                    break
+            pc = next_pc
+            if pc in stop_pcs:
+                reason = StopReason.STOP_PC
+                break
+        self.pc = pc
+        stats.flush_runs(self, pc - 4)
+        return retired, reason
+
+    def _is_idle_loop(self, entry):
+        """True if entry, having just jumped to its own pc, will keep doing so with no side effects.
+
+        Only control transfers can target their own pc; a branch or jal to itself is idle,
+        and so is a jalr unless it overwrites the register it jumps through.
+        """
+        handler, rd, rs1 = entry[0], entry[1], entry[2]
+        return handler is not type(self)._op_jalr or rd == 0 or rd != rs1
+
+    def _halt_reason(self):
+        """Classifies why execution cannot continue at self.pc."""
+        word = self.memory.load_word(self.pc) if 0 <= self.pc <= 0xFFFFFFFC else 0
+        return StopReason.HALTED if word == 0 else StopReason.TRAP
+
+    # --- Reverse execution ---
+    # With history enabled, run() logs an undo record per retired instruction (see
+    # ExecutionHistory). Stepping back within the ring undoes records one by one; going
+    # further restores the nearest older checkpoint and re-executes forward, which relies
+    # on execution being deterministic: memory or registers changed from outside between
+    # runs are not recorded. Re-execution is always interpreted, so a stretch run
+    # unrecorded on a block engine replays differently only if a store rewrote code
+    # later in the block executing it (which that block still ran as translated).
+
+    def enable_history(self, capacity=1 << 16, checkpoint_interval=1 << 16, max_checkpoints=16):
+        self.history = ExecutionHistory(capacity, checkpoint_interval, max_checkpoints)
+
+    def disable_history(self):
+        self.history = None
+
+    def _run_checkpointed(self, max_instructions, stop_pcs):
+        # Unrecorded: the selected engine runs up to each checkpoint position, so anything
+        # it ran through is reached again by re-executing from the checkpoint before it.
+        history, retired = self.history, 0
+        while True:
+            if history.position >= history.next_checkpoint: self._take_checkpoint()
+            budget = min(max_instructions - retired, history.next_checkpoint - history.position)
+            done, reason = self._run_selected(budget, stop_pcs)
+            retired += done
+            history.position += done
+            history.oldest = history.position
+            if reason is not StopReason.BUDGET or retired >= max_instructions: return retired, reason
+
+    # --- Profiling ---
+    # Counting code is only emitted into blocks translated while profiling is on, so
+    # toggling it drops the translated blocks; disabled profiling costs one None check per
+    # interpreted instruction and nothing in translated code. reset() starts a fresh
+    # Profile, as it does the Statistics.
+
+    def enable_profiling(self):
+        """Starts a fresh Profile in self.profile and returns it."""
+        self.profile = Profile()
+        self._drop_blocks()
+        return self.profile
+
+    def disable_profiling(self):
+        """Stops profiling; returns the collected Profile."""
+        profile, self.profile = self.profile, None
+        self._drop_blocks()
+        return profile
+
+    # --- Call-stack sampling ---
+    # Calls and returns update the sampler's shadow stack as they execute: the jal/jalr
+    # handlers do it for interpreted code and blocks translated while sampling is on carry
+    # the same hooks. run() hands the engine at most `countdown` instructions at a time and
+    # samples whenever that reaches zero, so samples fall on exact instruction counts on
+    # every engine. Stepping back does not rewind the shadow stack.
+
+    def enable_sampling(self, period=1000, max_depth=1024):
+        """Starts a fresh CallStackSampler rooted at the current pc and returns it."""
+        self.sampler = CallStackSampler(self.pc, period, max_depth)
+        self._drop_blocks()
+        return self.sampler
+
+    def disable_sampling(self):
+        """Stops sampling; returns the CallStackSampler with the samples taken so far."""
+        sampler, self.sampler = self.sampler, None
+        self._drop_blocks()
+        return sampler
+
+    def _run_sampled(self, max_instructions, stop_pcs):
+        sampler = self.sampler
+        retired = 0
+        while True:
+            done, reason = self._run_engine(min(max_instructions - retired, sampler.countdown), stop_pcs)
+            retired += done
+            sampler.countdown -= done
+            if sampler.countdown <= 0: sampler.sample()
+            if reason is not StopReason.BUDGET or retired >= max_instructions: return retired, reason
+
+    # --- Execution tracing ---
+    # The tracing interpreter fills the writer's per-chunk columns (see tracefile.py): a
+    # flags byte per instruction, the pc delta after a jump or taken branch, the
+    # instruction word the first time a chunk sees each decoded pc, and the value of
+    # every rd write. Memory addresses and store values are left out; readers recompute
+    # them from the register state, which each chunk starts with a copy of.
+
+    def enable_tracing(self, writer):
+        """Streams every instruction run() retires into writer (a tracefile.TraceWriter)."""
+        self.tracer = writer
+
+    def disable_tracing(self):
+        """Stops tracing; returns the writer, which the caller closes."""
+        tracer, self.tracer = self.tracer, None
+        return tracer
+
+    def _run_tracing(self, max_instructions, stop_pcs):
+        tracer, registers, memory = self.tracer, self.registers, self.memory
+        writes_rd, branches = self._WRITES_RD, self._BRANCH_CONDITIONS
+        pc_counts = self.profile.pc_counts if self.profile is not None else None
+        op_counts, taken = self.stats.op_counts, 0
+        retired, reason = 0, StopReason.BUDGET
+        pc = self.pc
+        # The state may have been changed since the last call; a new chunk records it.
+        if pc != tracer.end_pc or registers != tracer.end_registers: tracer.cut(pc, registers)
+        flags, deltas, words, values, seen = tracer.columns()
+        limit = tracer.chunk_records
+        while retired < max_instructions:
+            entry = self.decode_cache.get(pc) or self._decode(pc)
+            if entry is None:
+                reason = StopReason.HALTED
+                break
+            if len(flags) >= limit:
+                tracer.cut(pc, registers)
+                flags, deltas, words, values, seen = tracer.columns()
+            if pc_counts is not None: pc_counts[pc] += 1
+            handler, rd, rs1, rs2, imm = entry
+            flag = 0
+            if seen.get(pc) is not entry:
+                seen[pc] = entry
+                words.append(memory.load_word(pc))
+                flag = 2
+            op_counts[handler] += 1
+            next_pc = handler(self, pc, rd, rs1, rs2, imm)
+            registers[0] = 0
+            retired += 1
+            if rd and handler in writes_rd:
+                values.append(registers[rd])
+                flag |= 4
+            if next_pc != pc + 4:
+                deltas.append(next_pc - pc - 4)
+                flags.append(flag | 1)
+                if handler in branches: taken += 1
+                if next_pc == pc and self._is_idle_loop(entry):
+                    reason = StopReason.HALTED_IDLE
+                    break
+            else:
+                flags.append(flag)
+            pc = next_pc
+            if pc in stop_pcs:
+                reason = StopReason.STOP_PC
+                break
+        self.pc = pc
+        self.stats.taken += taken
+        tracer.end_pc, tracer.end_registers = pc, registers[:]
+        return retired, reason
+
+    def _drop_blocks(self):
+        self.block_cache.clear()
+        self._block_heat.clear()
+
+    def _run_recording(self, max_instructions, stop_pcs):
+        history, registers, memory = self.history, self.registers, self.memory
+        store_sizes, writes_rd = self.STORE_SIZES, self._WRITES_RD
+        # Ring slot i = position % capacity; see ExecutionHistory.
+        pcs, rds, old_values = history.pcs, history.rds, history.old_values
+        addresses, sizes, old_bytes = history.addresses, history.sizes, history.old_bytes
+        capacity = history.capacity
+        pc_counts = self.profile.pc_counts if self.profile is not None else None
+        op_counts, branches, taken = self.stats.op_counts, self._BRANCH_CONDITIONS, 0
+        retired, reason = 0, StopReason.BUDGET
+        pc = self.pc
+        while retired < max_instructions:
+            entry = self.decode_cache.get(pc) or self._decode(pc)
+            if entry is None:
+                reason = StopReason.HALTED
+                break
+            if pc_counts is not None: pc_counts[pc] += 1
+            position = history.position
+            if position >= history.next_checkpoint:
+                self.pc = pc
+                self._take_checkpoint()
+            handler, rd, rs1, rs2, imm = entry
+            i = position % capacity
+            pcs[i] = pc
+            size = store_sizes.get(handler, 0)
+            sizes[i] = size
+            if size:
+                rds[i] = 0
+                address = addresses[i] = (registers[rs1] + imm) & 0xFFFFFFFF
+                old_bytes[i] = memory.load(address, size)
+            elif handler in writes_rd:
+                rds[i], old_values[i] = rd, registers[rd]
+            else:
+                rds[i] = 0
+            history.position = position + 1
+            if position - history.oldest >= capacity: history.oldest += 1
+            op_counts[handler] += 1
+            next_pc = handler(self, pc, rd, rs1, rs2, imm)
+            registers[0] = 0
+            retired += 1
+            if next_pc != pc + 4:
+                if handler in branches: taken += 1
+                if next_pc == pc and self._is_idle_loop(entry):
+                    reason = StopReason.HALTED_IDLE
+                    break
+            pc = next_pc
+            if pc in stop_pcs:
+                reason = StopReason.STOP_PC
+                break
+        self.pc = pc
+        self.stats.taken += taken
+        return retired, reason
+
+    def _take_checkpoint(self):
+        history = self.history
+        history.checkpoints.append((history.position, self.pc, self.registers[:], self.memory.fork()))
+        history.next_checkpoint = history.position + history.checkpoint_interval
+
+    def _undo_last(self):
+        history = self.history
+        history.position -= 1
+        i = history.position % history.capacity
+        self.registers[history.rds[i]] = history.old_values[i]
+        self.registers[0] = 0
+        size = history.sizes[i]
+        if size:
+            address = history.addresses[i]
+            self.memory.store(address, size, history.old_bytes[i])
+            self._invalidate_code(address, size)
+        self.pc = history.pcs[i]
+
+    def step_back(self, count=1):
+        """Undoes the last count recorded instructions; returns how many were actually undone.
+
+        Stops early at the oldest position still reachable through the ring or a checkpoint.
+        """
+        history = self.history
+        if history is None: return 0
+        start = history.position
+        target = max(0, start - count)
+        if target < history.oldest:
+            checkpoint = None
+            for candidate in history.checkpoints:
+                if candidate[0] > target: break
+                checkpoint = candidate
+            if checkpoint is None and history.checkpoints and history.checkpoints[0][0] < history.oldest:
+                # Older than every checkpoint: go as far as the oldest one.
+                checkpoint = history.checkpoints[0]
+                target = checkpoint[0]
+            if checkpoint is None:
+                target = history.oldest
+            else:
+                position, pc, registers, memory = checkpoint
+                self.memory.share_pages(memory)
+                self.invalidate_decode_cache()
+                self.registers[:] = registers
+                self.pc = pc
+                history.position = history.oldest = position
+                history.next_checkpoint = position + history.checkpoint_interval
+                # Re-execute up to the target; this also refills the ring. The replay ran
+                # before, so it is kept out of the statistics, profile and call stack.
+                counters = self.stats, self.profile, self.sampler
+                self.stats, self.profile, self.sampler = Statistics(), None, None
+                try:
+                    while history.position < target:
+                        if self._run_recording(target - history.position, frozenset())[0] == 0: break
+                finally:
+                    self.stats, self.profile, self.sampler = counters
+        while history.position > target:
+            self._undo_last()
+        while history.checkpoints and history.checkpoints[-1][0] > history.position:
+            history.checkpoints.pop()
+        if history.checkpoints:
+            history.next_checkpoint = history.checkpoints[-1][0] + history.checkpoint_interval
+        else:
+            history.next_checkpoint = history.position
+        return start - history.position
+
+    def run_back_to_write(self, reg):
+        """Steps back to the most recent recorded instruction that wrote x<reg>.
+
+        The pc is left on that instruction with the register holding its previous value.
+        Returns the number of instructions undone, or None (changing nothing) if the
+        ring holds no such write.
+        """
+        history = self.history
+        if history is None or reg == 0: return None
+        for position in range(history.position - 1, history.oldest - 1, -1):
+            if history.rds[position % history.capacity] == reg:
+                return self.step_back(history.position - position)
+        return None
+
+    # --- Basic-block translation ---
+    # Blocks run to their first branch/jump (or MAX_BLOCK_LENGTH instructions) and are
+    # compiled once, then looked up by start pc. Direct exits are chained to their
+    # successor block the first time they are taken, and jalr exits check a two-entry
+    # target cache, so steady-state loops never go back through block_cache. A store
+    # that overwrites a translated block drops it and unlinks every chain; the block
+    # currently executing still finishes as translated.
+    #
+    # Inside a block, guest registers live in Python locals (x5, x6, ...): those read
+    # before being written are loaded on entry and every written one is stored back
+    # right before the block returns.
+    #
+    # The 'jit' engine is tiered: a block is only translated once it has been entered
+    # JIT_THRESHOLD times; until then (and for code that never gets hot) the predecoded
+    # interpreter runs it, so one-off code never pays compile() cost.
+
+    # The loops below return (retired, reason); reason is None when they simply ran
+    # out of code to execute (halt, or cold code for the 'jit' engine).
+
+    def _run_tiered(self, max_instructions, stop_pcs):
+        retired = 0
+        block = self._lookup_block(self.pc)
+        while True:
+            if block is not None:
+                done, reason = self._run_chain(block, max_instructions - retired, stop_pcs)
+                retired += done
+                if reason is not None: return retired, reason
+                if self.pc in stop_pcs: return retired, StopReason.STOP_PC
+            # Cold (or halted) code at self.pc: interpret it up to the end of its block.
+            done, reason = self._interpret_block(max_instructions - retired, stop_pcs)
+            retired += done
+            if reason is not None: return retired, reason
+            block = self._lookup_block(self.pc)
+
+    def _interpret_block(self, max_instructions, stop_pcs):
+        """Single-steps from self.pc through the end of the current block."""
+        retired = 0
+        terminators = self._TERMINATOR_OPS
+        pc_counts = self.profile.pc_counts if self.profile is not None else None
+        while True:
+            if retired >= max_instructions: return retired, StopReason.BUDGET
+            pc = self.pc
+            entry = self.decode_cache.get(pc) or self._decode(pc)
+            if entry is None: return retired, StopReason.HALTED
+            if pc_counts is not None: pc_counts[pc] += 1
+            self.run_single_step()
+            retired += 1
+            if self.pc == pc and self._is_idle_loop(entry): return retired, StopReason.HALTED_IDLE
+            if self.pc in stop_pcs: return retired, StopReason.STOP_PC
+            if entry[0] in terminators: return retired, None
+
+    def _run_chain(self, block, max_instructions, stop_pcs):
+        retired = 0
+        registers = self.registers
+        # Blocks with a stop pc after their first instruction are stepped, not run whole.
+        contains_stop = {}
+        while block is not None:
+            careful = retired + block.length > max_instructions
+            if stop_pcs:
+                if retired and block.start in stop_pcs:
+                    self.pc = block.start
+                    return retired, StopReason.STOP_PC
+                inside = contains_stop.get(block)
+                if inside is None:
+                    inside = contains_stop[block] = any(block.start < pc < block.end for pc in stop_pcs)
+                careful = careful or inside
+            if careful:
+                self.pc = block.start
+                done, reason = self._interpret_block(max_instructions - retired, stop_pcs)
+                retired += done
+                if reason is not None: return retired, reason
+                block = self._lookup_block(self.pc)
+                continue
+            retired += block.length
+            block = block.fn(registers)
+        # Checked in the interpreter's order: idle, stop pc, budget, then the code at self.pc.
+        if self._idle: return retired, StopReason.HALTED_IDLE
+        if retired and self.pc in stop_pcs: return retired, StopReason.STOP_PC
+        return retired, StopReason.BUDGET if retired == max_instructions else None
+
+    def _lookup_block(self, pc):
+        """Returns the translated block at pc, or None (with self.pc = pc) on halt or cold jit code."""
+        block = self.block_cache.get(pc)
+        if block is None:
+            if self.engine == 'jit':
+                heat = self._block_heat.get(pc, 0) + 1
+                self._block_heat[pc] = heat
+                if heat < self.JIT_THRESHOLD:
+                    self.pc = pc
+                    return None
+            block = self._translate_block(pc)
+            if block is None: self.pc = pc
+        return block
+
+    def _idle_exit(self, pc):
+        self.pc = pc
+        self._idle = True
+        return None
+
+    def _link_exit(self, links, slot, target):
+        block = self._lookup_block(target)
+        if block is not None: links[slot] = block
+        return block
+
+    def _jalr_miss(self, jalr_cache, target):
+        block = self._lookup_block(target)
+        if block is not None:
+            jalr_cache[:] = [target, block, jalr_cache[0], jalr_cache[1]]
+        return block
+
+    def _translate_block(self, start):
+        cls = type(self)
+        body, loaded, written, handlers = [], [], set(), []
+        counted = False
+        pc, terminated = start, False
+        while pc - start < 4 * self.MAX_BLOCK_LENGTH:
+            entry = self.decode_cache.get(pc) or self._decode(pc)
+            if entry is None: break
+            handler, rd, rs1, rs2, imm = entry
+            next_pc, target = (pc + 4) & 0xFFFFFFFF, (pc + imm) & 0xFFFFFFFF
+            template = self._BLOCK_TEMPLATES[handler]
+            handlers.append(handler)
+            hook = None
+            if self.sampler is not None and handler in (cls._op_jal, cls._op_jalr):
+                if rd == 1:
+                    callee = f"{target:#x}" if handler is cls._op_jal else "t"
+                    hook = f"call({callee}, {next_pc:#x})"
+                elif handler is cls._op_jalr and rd == 0 and rs1 == 1: hook = "ret(t)"
+            text = "\n".join(template)
+            for reg, used in ((rs1, '{a}' in text), (rs2, '{b}' in text)):
+                if used and reg != 0 and reg not in written and reg not in loaded:
+                    loaded.append(reg)
+            body.append(f"    # {pc:#06x}: {self.disassemble(pc)}")
+            for line in template:
+                line = line.format(d=f"x{rd}", a=f"x{rs1}" if rs1 else "0", b=f"x{rs2}" if rs2 else "0",
+                                   imm=imm, next=hex(next_pc), target=hex(target),
+                                   fall=f"(links[0] or link(0, {next_pc:#x}))",
+                                   take=f"idle({pc:#x})" if imm == 0 else f"(links[1] or link(1, {target:#x}))",
+                                   self_jump=f"idle(t) if t == {pc:#x} else " if rd == 0 or rd != rs1 else "")
+                if line.startswith('x0 ='): continue  # x0 writes are dropped at translation time
+                if line.startswith(f"x{rd} ="): written.add(rd)
+                if line.startswith('return'):
+                    if handler in cls._BRANCH_CONDITIONS and imm != 4:  # taken = not falling through
+                        body.append("    st[t] += 1")
+                        counted = True
+                    if hook: body.append('    ' + hook)
+                    body.append(None)  # write-back point
+                body.append('    ' + line)
+            pc += 4
+            if handler in self._TERMINATOR_OPS:
+                terminated = True
+                break
+        if pc == start: return None
+        if not terminated:
+            body += [None, f"    return links[0] or link(0, {pc:#x})"]
+
+        write_back = [f"    r[{reg}] = x{reg}" for reg in sorted(written)]
+        lines = [f"    x{reg} = r[{reg}]" for reg in loaded]
+        if not counted: lines.insert(0, "    st[0] += 1")
+        if self.profile is not None:
+            lines.insert(0, f"    bh[{self.profile.add_block(start, pc)}] += 1")
+        for line in body:
+            if line is None: lines.extend(write_back)
+            else: lines.append(line)
+        source = "def block(r):\n" + "\n".join(lines) + "\n"
+        block = TranslatedBlock(start, pc, (pc - start) // 4, source)
+        memory = self.memory
+        namespace = {'lb': memory.load_byte_signed, 'lbu': memory.load_byte,
+                     'lh': memory.load_half_signed, 'lhu': memory.load_half, 'lw': memory.load_word,
+                     'sb': memory.store_byte, 'sh': memory.store_half, 'sw': memory.store_word,
+                     'div32': _div32, 'rem32': _rem32, 'sim': self,
+                     'links': block.links, 'jc': block.jalr_cache,
+                     'link': functools.partial(self._link_exit, block.links), 'jalr_miss': self._jalr_miss,
+                     'idle': self._idle_exit, 'st': self.stats.add_block(tuple(handlers))}
+        if self.profile is not None: namespace['bh'] = self.profile.block_hits
+        if self.sampler is not None: namespace.update(call=self.sampler.call, ret=self.sampler.ret)
+        exec(compile(source, f"<block {start:#06x}>", 'exec'), namespace)
+        block.fn = namespace['block']
+        self.block_cache[start] = block
+        for word in range(start >> 2, (pc + 3) >> 2):
+            self._code_words.add(word)
+        return block
+
+    # --- Instruction handlers: (sim, pc, rd, rs1, rs2, imm) -> next_pc ---
+
+    def _op_add(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] + self.registers[rs2]) & 0xFFFFFFFF; return pc + 4
+    def _op_sub(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] - self.registers[rs2]) & 0xFFFFFFFF; return pc + 4
+    def _op_xor(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] ^ self.registers[rs2]; return pc + 4
+    def _op_or(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] | self.registers[rs2]; return pc + 4
+    def _op_and(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] & self.registers[rs2]; return pc + 4
+    def _op_sll(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] << (self.registers[rs2] & 0x1F)) & 0xFFFFFFFF; return pc + 4
+    def _op_srl(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] >> (self.registers[rs2] & 0x1F); return pc + 4
+    def _op_sra(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.signed_registers[rs1] >> (self.registers[rs2] & 0x1F)) & 0xFFFFFFFF; return pc + 4
+    def _op_slt(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = 1 if self.signed_registers[rs1] < self.signed_registers[rs2] else 0; return pc + 4
+    def _op_sltu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = 1 if self.registers[rs1] < self.registers[rs2] else 0; return pc + 4
+
+    def _op_mul(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] * self.registers[rs2]) & 0xFFFFFFFF; return pc + 4
+    def _op_mulh(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = ((self.signed_registers[rs1] * self.signed_registers[rs2]) >> 32) & 0xFFFFFFFF
+        return pc + 4
+    def _op_mulhsu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = ((self.signed_registers[rs1] * self.registers[rs2]) >> 32) & 0xFFFFFFFF; return pc + 4
+    def _op_mulhu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] * self.registers[rs2]) >> 32; return pc + 4
+    def _op_div(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = _div32(self.signed_registers[rs1], self.signed_registers[rs2]); return pc + 4
+    def _op_divu(self, pc, rd, rs1, rs2, imm):
+        divisor = self.registers[rs2]
+        self.registers[rd] = self.registers[rs1] // divisor if divisor else 0xFFFFFFFF; return pc + 4
+    def _op_rem(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = _rem32(self.signed_registers[rs1], self.signed_registers[rs2]); return pc + 4
+    def _op_remu(self, pc, rd, rs1, rs2, imm):
+        divisor = self.registers[rs2]
+        self.registers[rd] = self.registers[rs1] % divisor if divisor else self.registers[rs1]; return pc + 4
+
+    def _op_addi(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] + imm) & 0xFFFFFFFF; return pc + 4
+    def _op_slti(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = 1 if self.signed_registers[rs1] < imm else 0; return pc + 4
+    def _op_sltiu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = 1 if self.registers[rs1] < (imm & 0xFFFFFFFF) else 0; return pc + 4
+    def _op_xori(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] ^ imm) & 0xFFFFFFFF; return pc + 4
+    def _op_ori(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] | imm) & 0xFFFFFFFF; return pc + 4
+    def _op_andi(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] & imm; return pc + 4
+    # Immediate shifts get the shift amount as imm.
+    def _op_slli(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.registers[rs1] << imm) & 0xFFFFFFFF; return pc + 4
+    def _op_srli(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.registers[rs1] >> imm; return pc + 4
+    def _op_srai(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (self.signed_registers[rs1] >> imm) & 0xFFFFFFFF; return pc + 4
+
+    def _op_lb(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.memory.load_byte_signed(self.registers[rs1] + imm) & 0xFFFFFFFF; return pc + 4
+    def _op_lbu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.memory.load_byte(self.registers[rs1] + imm); return pc + 4
+    def _op_lh(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.memory.load_half_signed(self.registers[rs1] + imm) & 0xFFFFFFFF; return pc + 4
+    def _op_lhu(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.memory.load_half(self.registers[rs1] + imm); return pc + 4
+    def _op_lw(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = self.memory.load_word(self.registers[rs1] + imm); return pc + 4
+
+    def _op_sb(self, pc, rd, rs1, rs2, imm):
+        address = (self.registers[rs1] + imm) & 0xFFFFFFFF
+        self.memory.store_byte(address, self.registers[rs2])
+        self._invalidate_code(address, 1, pc); return pc + 4
+    def _op_sh(self, pc, rd, rs1, rs2, imm):
+        address = (self.registers[rs1] + imm) & 0xFFFFFFFF
+        self.memory.store_half(address, self.registers[rs2])
+        self._invalidate_code(address, 2, pc); return pc + 4
+    def _op_sw(self, pc, rd, rs1, rs2, imm):
+        address = (self.registers[rs1] + imm) & 0xFFFFFFFF
+        self.memory.store_word(address, self.registers[rs2])
+        self._invalidate_code(address, 4, pc); return pc + 4
+
+    # Equality and unsigned comparisons work on the raw values; only blt/bge need the signed view.
+    def _op_beq(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.registers[rs1] == self.registers[rs2] else pc + 4
+    def _op_bne(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.registers[rs1] != self.registers[rs2] else pc + 4
+    def _op_blt(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.signed_registers[rs1] < self.signed_registers[rs2] else pc + 4
+    def _op_bge(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.signed_registers[rs1] >= self.signed_registers[rs2] else pc + 4
+    def _op_bltu(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.registers[rs1] < self.registers[rs2] else pc + 4
+    def _op_bgeu(self, pc, rd, rs1, rs2, imm):
+        return (pc + imm) & 0xFFFFFFFF if self.registers[rs1] >= self.registers[rs2] else pc + 4
+
+    def _op_lui(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = imm; return pc + 4
+    def _op_auipc(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (pc + imm) & 0xFFFFFFFF; return pc + 4
+    def _op_jal(self, pc, rd, rs1, rs2, imm):
+        self.registers[rd] = (pc + 4) & 0xFFFFFFFF
+        if rd == 1 and self.sampler is not None: self.sampler.call((pc + imm) & 0xFFFFFFFF, (pc + 4) & 0xFFFFFFFF)
+        return (pc + imm) & 0xFFFFFFFF
+    def _op_jalr(self, pc, rd, rs1, rs2, imm):
+        target = (self.registers[rs1] + imm) & 0xFFFFFFFE
+        if self.sampler is not None:
+            if rd == 1: self.sampler.call(target, (pc + 4) & 0xFFFFFFFF)
+            elif rd == 0 and rs1 == 1: self.sampler.ret(target)
+        self.registers[rd] = (pc + 4) & 0xFFFFFFFF
+        return target
+
+    # Every supported encoding as (mnemonic, format, opcode, funct3, funct7, handler); a
+    # funct3/funct7 of None means those bits are part of the immediate. _DISPATCH, built
+    # from this list, is the only place decoding, disassembly and statistics look up an
+    # instruction, keyed by _dispatch_key(word).
+    _INSTRUCTION_SET = (
+        ('add', 'R', 0x33, 0x0, 0x00, _op_add), ('sub', 'R', 0x33, 0x0, 0x20, _op_sub),
+        ('sll', 'R', 0x33, 0x1, 0x00, _op_sll), ('slt', 'R', 0x33, 0x2, 0x00, _op_slt),
+        ('sltu', 'R', 0x33, 0x3, 0x00, _op_sltu), ('xor', 'R', 0x33, 0x4, 0x00, _op_xor),
+        ('srl', 'R', 0x33, 0x5, 0x00, _op_srl), ('sra', 'R', 0x33, 0x5, 0x20, _op_sra),
+        ('or', 'R', 0x33, 0x6, 0x00, _op_or), ('and', 'R', 0x33, 0x7, 0x00, _op_and),
+        ('mul', 'R', 0x33, 0x0, 0x01, _op_mul), ('mulh', 'R', 0x33, 0x1, 0x01, _op_mulh),
+        ('mulhsu', 'R', 0x33, 0x2, 0x01, _op_mulhsu), ('mulhu', 'R', 0x33, 0x3, 0x01, _op_mulhu),
+        ('div', 'R', 0x33, 0x4, 0x01, _op_div), ('divu', 'R', 0x33, 0x5, 0x01, _op_divu),
+        ('rem', 'R', 0x33, 0x6, 0x01, _op_rem), ('remu', 'R', 0x33, 0x7, 0x01, _op_remu),
+        ('addi', 'I', 0x13, 0x0, None, _op_addi), ('slti', 'I', 0x13, 0x2, None, _op_slti),
+        ('sltiu', 'I', 0x13, 0x3, None, _op_sltiu), ('xori', 'I', 0x13, 0x4, None, _op_xori),
+        ('ori', 'I', 0x13, 0x6, None, _op_ori), ('andi', 'I', 0x13, 0x7, None, _op_andi),
+        ('slli', 'SH', 0x13, 0x1, 0x00, _op_slli), ('srli', 'SH', 0x13, 0x5, 0x00, _op_srli),
+        ('srai', 'SH', 0x13, 0x5, 0x20, _op_srai),
+        ('lb', 'L', 0x03, 0x0, None, _op_lb), ('lh', 'L', 0x03, 0x1, None, _op_lh),
+        ('lw', 'L', 0x03, 0x2, None, _op_lw), ('lbu', 'L', 0x03, 0x4, None, _op_lbu),
+        ('lhu', 'L', 0x03, 0x5, None, _op_lhu),
+        ('sb', 'S', 0x23, 0x0, None, _op_sb), ('sh', 'S', 0x23, 0x1, None, _op_sh),
+        ('sw', 'S', 0x23, 0x2, None, _op_sw),
+        ('beq', 'B', 0x63, 0x0, None, _op_beq), ('bne', 'B', 0x63, 0x1, None, _op_bne),
+        ('blt', 'B', 0x63, 0x4, None, _op_blt), ('bge', 'B', 0x63, 0x5, None, _op_bge),
+        ('bltu', 'B', 0x63, 0x6, None, _op_bltu), ('bgeu', 'B', 0x63, 0x7, None, _op_bgeu),
+        ('lui', 'U', 0x37, None, None, _op_lui), ('auipc', 'U', 0x17, None, None, _op_auipc),
+        ('jal', 'J', 0x6F, None, None, _op_jal), ('jalr', 'JR', 0x67, 0x0, None, _op_jalr),
+    )
+    _DISPATCH = _build_dispatch(_INSTRUCTION_SET)
+    MNEMONICS = {spec.handler: spec.mnemonic for spec in _DISPATCH.values()}
+
+    # Python source emitted by _translate_block for each handler, one list entry per line.
+    # {d} is the local caching rd, {a}/{b} the values of rs1/rs2, {imm} the immediate,
+    # {next} = pc + 4 and {target} = pc + imm; {fall}/{take} evaluate to the chained
+    # block at next/target (a jump to the instruction itself ends the run as idle, and
+    # {self_jump} does the same for a jalr whose target turns out to be its own pc).
+    # Locals hold the same unsigned 32-bit values as the register file; _S1/_S2 give
+    # their two's-complement reading for the signed operations.
+    _S1 = "(({a} ^ 0x80000000) - 0x80000000)"
+    _S2 = "(({b} ^ 0x80000000) - 0x80000000)"
+    # Condition under which each branch is taken; translated blocks also index their
+    # statistics counter with it.
+    _BRANCH_CONDITIONS = {
+        _op_beq: "{a} == {b}",
+        _op_bne: "{a} != {b}",
+        _op_blt: f"{_S1} < {_S2}",
+        _op_bge: f"{_S1} >= {_S2}",
+        _op_bltu: "{a} < {b}",
+        _op_bgeu: "{a} >= {b}",
+    }
+    _BLOCK_TEMPLATES = {
+        _op_add: ["{d} = ({a} + {b}) & 0xFFFFFFFF"],
+        _op_sub: ["{d} = ({a} - {b}) & 0xFFFFFFFF"],
+        _op_xor: ["{d} = {a} ^ {b}"],
+        _op_or: ["{d} = {a} | {b}"],
+        _op_and: ["{d} = {a} & {b}"],
+        _op_sll: ["{d} = ({a} << ({b} & 0x1F)) & 0xFFFFFFFF"],
+        _op_srl: ["{d} = {a} >> ({b} & 0x1F)"],
+        _op_sra: [f"{{d}} = ({_S1} >> ({{b}} & 0x1F)) & 0xFFFFFFFF"],
+        _op_slt: [f"{{d}} = 1 if {_S1} < {_S2} else 0"],
+        _op_sltu: ["{d} = 1 if {a} < {b} else 0"],
+        _op_mul: ["{d} = ({a} * {b}) & 0xFFFFFFFF"],
+        _op_mulh: [f"{{d}} = (({_S1} * {_S2}) >> 32) & 0xFFFFFFFF"],
+        _op_mulhsu: [f"{{d}} = (({_S1} * {{b}}) >> 32) & 0xFFFFFFFF"],
+        _op_mulhu: ["{d} = ({a} * {b}) >> 32"],
+        _op_div: [f"{{d}} = div32({_S1}, {_S2})"],
+        _op_divu: ["{d} = {a} // {b} if {b} else 0xFFFFFFFF"],
+        _op_rem: [f"{{d}} = rem32({_S1}, {_S2})"],
+        _op_remu: ["{d} = {a} % {b} if {b} else {a}"],
+        _op_addi: ["{d} = ({a} + {imm}) & 0xFFFFFFFF"],
+        _op_slti: [f"{{d}} = 1 if {_S1} < {{imm}} else 0"],
+        _op_sltiu: ["{d} = 1 if {a} < ({imm} & 0xFFFFFFFF) else 0"],
+        _op_xori: ["{d} = ({a} ^ {imm}) & 0xFFFFFFFF"],
+        _op_ori: ["{d} = ({a} | {imm}) & 0xFFFFFFFF"],
+        _op_andi: ["{d} = {a} & {imm}"],
+        _op_slli: ["{d} = ({a} << {imm}) & 0xFFFFFFFF"],
+        _op_srli: ["{d} = {a} >> {imm}"],
+        _op_srai: [f"{{d}} = ({_S1} >> {{imm}}) & 0xFFFFFFFF"],
+        _op_lb: ["{d} = lb({a} + {imm}) & 0xFFFFFFFF"],
+        _op_lbu: ["{d} = lbu({a} + {imm})"],
+        _op_lh: ["{d} = lh({a} + {imm}) & 0xFFFFFFFF"],
+        _op_lhu: ["{d} = lhu({a} + {imm})"],
+        _op_lw: ["{d} = lw({a} + {imm})"],
+        _op_sb: ["a = ({a} + {imm}) & 0xFFFFFFFF", "sb(a, {b})", "sim._invalidate_code(a, 1)"],
+        _op_sh: ["a = ({a} + {imm}) & 0xFFFFFFFF", "sh(a, {b})", "sim._invalidate_code(a, 2)"],
+        _op_sw: ["a = ({a} + {imm}) & 0xFFFFFFFF", "sw(a, {b})", "sim._invalidate_code(a, 4)"],
+        **{handler: ["t = " + condition, "return {take} if t else {fall}"] for handler, condition in _BRANCH_CONDITIONS.items()},
+        _op_lui: ["{d} = {imm}"],
+        _op_auipc: ["{d} = {target}"],
+        _op_jal: ["{d} = {next}", "return {take}"],
+        _op_jalr: ["t = ({a} + {imm}) & 0xFFFFFFFE", "{d} = {next}",
+                   "return {self_jump}jc[1] if jc[0] == t else jc[3] if jc[2] == t else jalr_miss(jc, t)"],
+    }
+    _TERMINATOR_OPS = {spec.handler for spec in _DISPATCH.values() if spec.format in ('B', 'J', 'JR')}
+    _WRITES_RD = {spec.handler for spec in _DISPATCH.values() if spec.format not in ('S', 'B')}
+    # Bytes each load and store handler moves.
+    STORE_SIZES = {_op_sb: 1, _op_sh: 2, _op_sw: 4}
+    LOAD_SIZES = {_op_lb: 1, _op_lbu: 1, _op_lh: 2, _op_lhu: 2, _op_lw: 4}
+    _OP_CLASSES = {spec.handler: {'L': 'load', 'S': 'store', 'B': 'branch', 'J': 'jump', 'JR': 'jump'}.get(
+        spec.format, 'muldiv' if spec.mnemonic.startswith(('mul', 'div', 'rem')) else 'alu') for spec in _DISPATCH.values()}
+
+EngineSnapshot = namedtuple('EngineSnapshot', ['sequence', 'pc', 'registers', 'dirty', 'instructions', 'reason',
+                                               'window', 'memory', 'dirty_pages', 'counters'])
+# Engine counters as of a snapshot: retired instructions and per-class counts (from
+# Statistics), the five hottest [(label, instructions)] (None without a profile) and
+# the number of memory pages allocated.
+PerformanceCounters = namedtuple('PerformanceCounters', ['instructions', 'classes', 'hot', 'pages'])
+
+class BackgroundRunner:
+    """Runs a simulator on a worker thread in batches of about `frame` seconds each.
+
+    Only the worker touches `sim` while running is True. After each batch it replaces
+    `snapshot` whole, so other threads always read a consistent EngineSnapshot; take()
+    also returns the registers and pages changed since the previous take().
+    """
+    MIN_BATCH, MAX_BATCH = 1 << 6, 1 << 22
+
+    def __init__(self, sim, frame=0.016, batch=1 << 12, window=(0x1000, 256)):
+        self.sim = sim
+        self.frame = frame
+        self.batch = batch
+        self.rate = None
+        self.window = window
+        self.label_of = None
+        self.instructions = 0
+        self.started = self.finished = 0.0
+        self.error = None  # exception that ended the last run, if any
+        self._thread = None
+        self._stop = threading.Event()
+        self._lock = threading.Lock()
+        self._dirty, self._dirty_pages = 0, set()
+        self._rendered_window, self._lines = None, []
+        self.snapshot = None
+        self.publish(None)
+
+    @property
+    def running(self):
+        return self._thread is not None and self._thread.is_alive()
+
+    def start(self, stop_pcs=()):
+        if self.running: return
+        self.instructions = 0
+        self.started = self.finished = time.perf_counter()
+        self.error = None
+        self._stop.clear()
+        self._thread = threading.Thread(target=self._work, args=(frozenset(stop_pcs),), daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        """Asks the worker to stop after its current batch and waits for it."""
+        self._stop.set()
+        if self._thread is not None: self._thread.join()
+        self._thread = None
+
+    def publish(self, reason):
+        """Replaces snapshot with the simulator's current state (call only while not running)."""
+        sim = self.sim
+        registers = sim.register_snapshot()
+        pages = sim.memory.take_dirty_pages()
+        window = self.window
+        memory = self._render(window, pages)
+        counters = self._counters()
+        with self._lock:
+            previous = self.snapshot
+            if previous is None:
+                sequence = 0
+            else:
+                sequence = previous.sequence + 1
+                self._dirty |= register_changes(previous.registers, registers)
+            self._dirty_pages |= pages
+            self.snapshot = EngineSnapshot(sequence, sim.pc, registers, self._dirty, self.instructions, reason,
+                                           window, memory, frozenset(self._dirty_pages), counters)
+
+    def _counters(self):
+        sim = self.sim
+        summary = sim.stats.summary()
+        hot = None
+        if sim.profile is not None:
+            label_of = self.label_of or (lambda pc: None)
+            by_label = defaultdict(int)
+            for pc, count in sim.profile.instruction_counts().items():
+                by_label[label_of(pc) or f"{pc:#010x}"] += count
+            hot = sorted(by_label.items(), key=lambda item: -item[1])[:5]
+        return PerformanceCounters(summary['instructions'], summary['classes'], hot, len(sim.memory.pages))
+
+    def _render(self, window, pages):
+        start, length = window
+        lines = self._lines
+        if window != self._rendered_window:
+            lines[:] = hexdump_lines(self.sim.memory, start, length)
+            self._rendered_window = window
+        else:
+            for row, address in enumerate(range(start, start + length, 16)):
+                if address >> PagedMemory.PAGE_SHIFT in pages:
+                    lines[row] = next(hexdump_lines(self.sim.memory, address, 16))
+        return tuple(lines)
+
+    def take(self):
+        """Returns the latest snapshot and starts new dirty masks."""
+        with self._lock:
+            self._dirty, self._dirty_pages = 0, set()
+            return self.snapshot
+
+    def instructions_per_second(self):
+        """Average speed of the current (or last) run."""
+        end = time.perf_counter() if self.running else self.finished
+        return self.instructions / (end - self.started) if end > self.started else 0.0
+
+    def _work(self, stop_pcs):
+        clock = time.perf_counter
+        paced_rate, paced_from, paced_done = None, 0.0, 0
+        while not self._stop.is_set():
+            rate, batch = self.rate, self.batch
+            if rate is not None:
+                now = clock()
+                if rate != paced_rate: paced_rate, paced_from, paced_done = rate, now, 0
+                # Wait until a frame's worth of instructions (at least one) is due.
+                due = int((now - paced_from) * rate) + 1 - paced_done
+                least = max(1, int(min(rate * self.frame, batch)))
+                if due < least:
+                    self._stop.wait(min(self.frame, (paced_done + least - 1) / rate - (now - paced_from)))
+                    continue
+                batch = min(batch, due)
+            began = clock()
+            try:
+                result = self.sim.run(batch, stop_pcs)
+            except Exception as e:
+                # Keep the error for the GUI and end the run as a trap, where it stopped.
+                self.error = e
+                self.finished = clock()
+                self.publish(StopReason.TRAP)
+                return
+            elapsed = clock() - began
+            paced_done += result.instructions
+            self.instructions += result.instructions
+            self.finished = clock()
+            if result.instructions == self.batch: self._tune(elapsed)
+            self.publish(result.reason)
+            if result.reason is not StopReason.BUDGET: return
+
+    def _tune(self, elapsed):
+        """Scales batch toward one frame's worth of instructions, at most doubling per step."""
+        target = self.batch * self.frame / max(elapsed, 1e-6)
+        self.batch = int(max(self.MIN_BATCH, min(self.MAX_BATCH, 2 * self.batch, target)))
+
 # =============================================================================
 #  بخش ۲: رابط کاربری گرافیکی (GUI) 
 # =============================================================================
 
 class SimulatorGUI:
-    def __init__(self, master):
+    # Run speeds offered in the GUI: instructions/second, or None for as fast as possible.
+    RUN_SPEEDS = (('1 instr/s', 1), ('10 instr/s', 10), ('100 instr/s', 100), ('1K instr/s', 1000),
+                  ('100K instr/s', 100_000), ('Turbo', None))
+
+    def __init__(self, master, engine='block'):
         self.master = master
         self.master.title("RISC-V Graphical Simulator")
         self.master.geometry("1100x800")
 
-        self.sim = RISCVSimulator()
+        self.sim = RISCVSimulator(engine=engine)
+        # History is recorded while stepping; Run goes at engine speed and only keeps
+        # checkpoints, which Step Back re-executes from.
+        self.sim.enable_history()
+        # The Performance panel's hottest labels come from the profile's per-pc counts.
+        self.sim.enable_profiling()
+        # Run executes on the runner's worker thread; the display is redrawn from its
+        # published snapshot every frame_interval ms (~60 Hz) instead of per instruction.
+        self.runner = BackgroundRunner(self.sim)
         self.running = False
-        self.run_speed = 50 
-        self.prev_regs = list(self.sim.registers)
+        self.frame_interval = 16
+        self.rate_mark = (0.0, 0)  # (time, instructions) the speed readout last measured from
+        self.current_rate = 0.0
+        self.highlighted = 0  # bitmask of register rows tagged 'changed'
+        # The memory pane is virtual: only mem_rows lines from mem_top are ever rendered.
+        self.mem_top, self.mem_rows = 0x1000, 16
+        self.mem_shown_window = None
+        self.symbolizer = None  # labels of the loaded program, from its .asm if found
         
         # --- تعریف تم رنگی ---
         self.matcha_green = "#E0EFE0"
@@ -187,7 +1793,7 @@ class SimulatorGUI:
         self._create_controls(left_frame)
         self._create_displays(right_frame)
 
-        self.update_display()
+        self.update_display(full=True)
 
     def _create_controls(self, parent):
         controls_frame = ttk.LabelFrame(parent, text="Controls", padding="10")
@@ -197,6 +1803,8 @@ class SimulatorGUI:
         self.load_btn.pack(fill="x", pady=5)
         self.step_btn = ttk.Button(controls_frame, text="➡️ Step", command=self.step)
         self.step_btn.pack(fill="x", pady=5)
+        self.back_btn = ttk.Button(controls_frame, text="⬅️ Step Back", command=self.step_back)
+        self.back_btn.pack(fill="x", pady=5)
         self.run_btn = ttk.Button(controls_frame, text="▶️ Run", command=self.run_toggle)
         self.run_btn.pack(fill="x", pady=5)
         self.reset_btn = ttk.Button(controls_frame, text="🔄 Reset", command=self.reset)
@@ -206,6 +1814,20 @@ class SimulatorGUI:
         pc_frame.pack(fill="x")
         self.pc_label = ttk.Label(pc_frame, text="PC: 0x0000", font=("Courier", 14, 'bold'), anchor="center")
         self.pc_label.pack(fill="x")
+        self.rate_label = ttk.Label(pc_frame, text="", font=("Courier", 10), anchor="center")
+        self.rate_label.pack(fill="x")
+
+        speed_frame = ttk.LabelFrame(parent, text="Run Speed", padding="10")
+        speed_frame.pack(fill="x", pady=(10, 0))
+        self.speed_box = ttk.Combobox(speed_frame, values=[name for name, _ in self.RUN_SPEEDS], state='readonly')
+        self.speed_box.set(self.RUN_SPEEDS[-1][0])
+        self.speed_box.pack(fill="x")
+        self.speed_box.bind('<<ComboboxSelected>>', lambda event: self.set_speed(self.speed_box.get()))
+
+        perf_frame = ttk.LabelFrame(parent, text="Performance", padding="10")
+        perf_frame.pack(fill="x", pady=(10, 0))
+        self.perf_label = ttk.Label(perf_frame, text="", font=("Courier", 9), justify="left", anchor="w")
+        self.perf_label.pack(fill="x")
 
     def _create_displays(self, parent):
         display_paned_window = ttk.PanedWindow(parent, orient=tk.VERTICAL)
@@ -226,78 +1848,218 @@ class SimulatorGUI:
         self.reg_tree.column('hex_val', width=150, anchor='center')
         self.reg_tree.column('dec_val', width=150, anchor='center')
         
+        for i in range(32):
+            self.reg_tree.insert('', 'end', iid=i, values=(f"x{i}", ABI_NAMES[i], "", ""))
         self.reg_tree.pack(fill="both", expand=True)
         
-        mem_frame = ttk.LabelFrame(display_paned_window, text="Memory View (from 0x1000)", padding="10")
+        mem_frame = ttk.LabelFrame(display_paned_window, text="Memory View", padding="10")
         display_paned_window.add(mem_frame, weight=1)
-        self.mem_text = scrolledtext.ScrolledText(mem_frame, height=10, width=80, font=("Courier", 10), relief="flat", borderwidth=2)
+        goto_frame = ttk.Frame(mem_frame)
+        goto_frame.pack(fill="x", pady=(0, 5))
+        ttk.Label(goto_frame, text="Go to (address, register or label):").pack(side="left")
+        self.goto_entry = ttk.Entry(goto_frame, width=20)
+        self.goto_entry.pack(side="left", padx=5)
+        self.goto_entry.bind('<Return>', lambda event: self.goto_memory())
+        ttk.Button(goto_frame, text="Go", command=self.goto_memory).pack(side="left")
+
+        mem_font = ("Courier", 10)
+        self.mem_line_height = tkfont.Font(font=mem_font).metrics('linespace')
+        self.mem_scrollbar = ttk.Scrollbar(mem_frame, orient=tk.VERTICAL, command=self.scroll_memory)
+        self.mem_scrollbar.pack(side="right", fill="y")
+        self.mem_text = tk.Text(mem_frame, height=self.mem_rows, width=80, font=mem_font, relief="flat",
+                                borderwidth=2, wrap="none")
         self.mem_text.pack(fill="both", expand=True)
         self.mem_text.config(state='disabled')
+        self.mem_text.bind('<Configure>', self._resize_memory)
+        # Windows reports multiples of 120 per notch and macOS small deltas; only the sign is used.
+        self.mem_text.bind('<MouseWheel>',
+                           lambda event: self.scroll_memory('scroll', -3 if event.delta > 0 else 3, 'units'))
+        self.mem_text.bind('<Button-4>', lambda event: self.scroll_memory('scroll', -3, 'units'))
+        self.mem_text.bind('<Button-5>', lambda event: self.scroll_memory('scroll', 3, 'units'))
+        self.runner.window = (self.mem_top, 16 * self.mem_rows)
 
     def load_file(self):
         filepath = filedialog.askopenfilename(filetypes=[("Binary files", "*.bin"), ("All files", "*.*")])
         if not filepath: return
+        self.pause()
         message = self.sim.load_program(filepath)
-        self.prev_regs = list(self.sim.registers)
+        self.symbolizer = self._load_symbols(filepath)
+        self.runner.label_of = None if self.symbolizer is None else self.symbolizer.label
         self.update_display()
         print(message)
 
     def step(self):
-        self.prev_regs = list(self.sim.registers)
-        if not self.sim.run_single_step():
-            self.running = False
-            self.run_btn.config(text="▶️ Run")
-            print("Simulation halted.")
+        self.pause()
+        result = self.sim.run(1)
+        if result.reason is not StopReason.BUDGET:
+            print(f"Simulation halted ({result.reason.value}).")
+        self.update_display()
+
+    def step_back(self):
+        self.pause()
+        if self.sim.step_back(1) == 0:
+            print("No earlier state recorded.")
         self.update_display()
 
     def run_toggle(self):
         if self.running:
-            self.running = False
-            self.run_btn.config(text="▶️ Run")
+            self.pause()
         else:
             self.running = True
             self.run_btn.config(text="⏸️ Pause")
-            self.run_loop()
-    
-    def run_loop(self):
-        if self.running:
-            self.step()
-            self.master.after(self.run_speed, self.run_loop)
+            self.sim.history.recording = False
+            self.runner.start()
+            self.rate_mark = (self.runner.started, 0)
+            self.master.after(self.frame_interval, self.refresh_loop)
 
-    def reset(self):
-        self.sim.reset()
+    def pause(self):
+        """Stops a background run (if any) and shows where it stopped."""
+        if not self.running: return
+        self.runner.stop()
+        self.sim.history.recording = True
         self.running = False
         self.run_btn.config(text="▶️ Run")
-        self.prev_regs = list(self.sim.registers)
+        self._show_rate(self.runner.instructions_per_second())
+        self.update_display()
+
+    def set_speed(self, name):
+        self.runner.rate = dict(self.RUN_SPEEDS)[name]
+
+    def _show_rate(self, ips):
+        text = f"{ips / 1e6:.2f} M instr/s" if ips >= 1e5 else f"{ips:.0f} instr/s"
+        self.rate_label.config(text=text)
+        self.current_rate = ips
+
+    def refresh_loop(self):
+        if not self.running: return
+        finished = not self.runner.running
+        snapshot = self.runner.snapshot
+        # The readout is the speed over the last half second or so, then the run's average.
+        now, (then, count) = time.perf_counter(), self.rate_mark
+        if finished:
+            self._show_rate(self.runner.instructions_per_second())
+        elif now - then >= 0.5:
+            self._show_rate((snapshot.instructions - count) / (now - then))
+            self.rate_mark = (now, snapshot.instructions)
+        if snapshot.sequence != self.shown_sequence:
+            self.update_display()
+        if finished:
+            self.sim.history.recording = True
+            self.running = False
+            self.run_btn.config(text="▶️ Run")
+            if self.runner.error is not None:
+                print(f"Simulation error at pc {snapshot.pc:#010x}: {self.runner.error!r}")
+            else:
+                print(f"Simulation halted ({snapshot.reason.value}).")
+        else:
+            self.master.after(self.frame_interval, self.refresh_loop)
+
+    def reset(self):
+        self.pause()
+        self.sim.reset()
         self.update_display()
         print("Simulator reset.")
 
-    def update_display(self):
-        self.pc_label.config(text=f"PC: {self.sim.pc:#06x}")
-        
-        abi_names = ['zero', 'ra', 'sp', 'gp', 'tp', 't0', 't1', 't2', 's0', 's1', 'a0', 'a1', 'a2', 'a3', 'a4', 'a5',
-                     'a6', 'a7', 's2', 's3', 's4', 's5', 's6', 's7', 's8', 's9', 's10', 's11', 't3', 't4', 't5', 't6']
-        
-        self.reg_tree.delete(*self.reg_tree.get_children())
+    def _load_symbols(self, filepath):
+        """Symbolizer for the .asm source next to a .bin, or None if there is none."""
+        source = os.path.splitext(filepath)[0] + '.asm'
+        if not os.path.exists(source): return None
+        from assembler import Symbolizer
+        try:
+            return Symbolizer.from_source(source)
+        except (ValueError, KeyError):
+            return None
+
+    # --- Memory pane ---
+    # The pane shows mem_rows lines of 16 bytes starting at mem_top, anywhere in the
+    # 4 GiB address space; the scrollbar is driven by hand since no widget holds more
+    # than the visible rows.
+    MEMORY_SPAN = 1 << 32
+
+    def _move_memory(self, top):
+        top = max(0, min(top, self.MEMORY_SPAN - 16 * self.mem_rows)) & ~0xF
+        self.mem_top = top
+        self.runner.window = (top, 16 * self.mem_rows)
+        if not self.running:
+            self.runner.publish(None)
+            self._update_memory(self.runner.snapshot)
+
+    def scroll_memory(self, *args):
+        """Scrollbar command: ('moveto', fraction) or ('scroll', count, 'units' | 'pages')."""
+        if args[0] == 'moveto':
+            self._move_memory(int(float(args[1]) * self.MEMORY_SPAN))
+        elif args[0] == 'scroll':
+            rows = int(args[1]) * (self.mem_rows if args[2] == 'pages' else 1)
+            self._move_memory(self.mem_top + 16 * rows)
+
+    def _resize_memory(self, event):
+        rows = max(1, event.height // self.mem_line_height)
+        if rows != self.mem_rows:
+            self.mem_rows = rows
+            self._move_memory(self.mem_top)
+
+    def goto_memory(self):
+        text = self.goto_entry.get().strip()
+        registers = self.runner.snapshot.registers
+        if self.symbolizer is not None and text in self.symbolizer.symbol_table:
+            address = self.symbolizer.symbol_table[text]
+        elif text in ABI_NAMES:
+            address = registers[ABI_NAMES.index(text)]
+        elif text[:1] == 'x' and text[1:].isdigit() and int(text[1:]) < 32:
+            address = registers[int(text[1:])]
+        else:
+            try:
+                address = int(text, 0) & 0xFFFFFFFF
+            except ValueError:
+                print(f"Unknown address, register or label '{text}'.")
+                return
+        self._move_memory(address)
+
+    def update_display(self, full=False):
+        # While a run is on, only the worker publishes: its last snapshot carries the stop reason.
+        if not self.running: self.runner.publish(None)
+        snapshot = self.runner.take()
+        self.shown_sequence = snapshot.sequence
+        self.pc_label.config(text=f"PC: {snapshot.pc:#06x}")
+
+        # Rows are only touched when their value changed or their highlight flips.
+        rows = 0xFFFFFFFF if full else snapshot.dirty | self.highlighted
         for i in range(32):
-            val = self.sim.registers[i]
-            signed_val = self._get_signed_val(val, 32)
-            tags = ()
-            if val != self.prev_regs[i]:
-                tags = ('changed',)
-            self.reg_tree.insert('', 'end', iid=i, tags=tags,
-                                 values=(f"x{i}", abi_names[i], f"{val:#010x}", str(signed_val)))
+            if not rows >> i & 1: continue
+            val = snapshot.registers[i]
+            tags = ('changed',) if snapshot.dirty >> i & 1 else ()
+            self.reg_tree.item(i, tags=tags,
+                               values=(f"x{i}", ABI_NAMES[i], f"{val:#010x}", str(self._get_signed_val(val, 32))))
+        self.highlighted = snapshot.dirty
+        self._update_memory(snapshot, full)
+        self._update_dashboard(snapshot.counters)
+
+    def _update_dashboard(self, counters):
+        """Redraws the Performance panel from a snapshot's PerformanceCounters."""
+        total = counters.instructions or 1
+        lines = [f"Retired {counters.instructions:>14,}", f"MIPS    {self.current_rate / 1e6:>14.3f}", "",
+                 "Instruction mix:"]
+        lines += [f"  {kind:<17}{100 * count / total:5.1f}%" for kind, count in counters.classes.items()]
+        if counters.hot:
+            lines += ["", "Hottest labels:"]
+            lines += [f"  {label[:16]:<17}{100 * count / total:5.1f}%" for label, count in counters.hot]
+        lines += ["", f"Pages touched {counters.pages:>4} ({counters.pages * PagedMemory.PAGE_SIZE // 1024} KiB)"]
+        self.perf_label.config(text="\n".join(lines))
 
+    def _update_memory(self, snapshot, full=False):
+        """Rewrites the pane when its window moved, else only the rows on written pages."""
         self.mem_text.config(state='normal')
-        self.mem_text.delete('1.0', tk.END)
-        addr_start = 0x1000
-        num_bytes_to_show = 256
-        for offset in range(0, num_bytes_to_show, 16):
-            addr = addr_start + offset
-            data_chunk = self.sim.memory[addr:addr+16]
-            hex_repr = ' '.join(f'{b:02x}' for b in data_chunk)
-            ascii_repr = ''.join(chr(b) if 32 <= b <= 126 else '.' for b in data_chunk)
-            self.mem_text.insert(tk.END, f"{addr:#06x}: {hex_repr:<48} |{ascii_repr}|\n")
+        if full or snapshot.window != self.mem_shown_window:
+            self.mem_text.delete('1.0', tk.END)
+            self.mem_text.insert(tk.END, "\n".join(snapshot.memory))
+            self.mem_shown_window = snapshot.window
+            top = snapshot.window[0]
+            self.mem_scrollbar.set(top / self.MEMORY_SPAN, (top + snapshot.window[1]) / self.MEMORY_SPAN)
+        elif snapshot.dirty_pages:
+            for row, address in enumerate(range(snapshot.window[0], sum(snapshot.window), 16)):
+                if address >> PagedMemory.PAGE_SHIFT in snapshot.dirty_pages:
+                    self.mem_text.delete(f"{row + 1}.0", f"{row + 1}.end")
+                    self.mem_text.insert(f"{row + 1}.0", snapshot.memory[row])
         self.mem_text.config(state='disabled')
 
     def _get_signed_val(self, val, bits):
@@ -307,5 +2069,5 @@ class SimulatorGUI:
 
 if __name__ == "__main__":
     root = tk.Tk()
-    app = SimulatorGUI(root)
+    app = SimulatorGUI(root, engine=sys.argv[1] if len(sys.argv) > 1 else 'block')
     root.mainloop()
@@ -0,0 +1,37 @@
+# Tests that the 'interp', 'block' and 'jit' engines stop for the same reason.
+#
+# Usage: python -m unittest test_engines   (from Src/)
+
+import unittest
+
+import assembler
+from simulator_core import RISCVSimulator, StopReason
+
+def assemble_lines(source):
+    lines = [assembler.clean_line(line) for line in source if assembler.clean_line(line)]
+    return bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+
+def run(image, engine, budget, stop_pcs=()):
+    sim = RISCVSimulator(engine=engine)
+    sim.JIT_THRESHOLD = 1
+    sim.load_image(image)
+    return sim.run(budget, stop_pcs)
+
+class BudgetBoundary(unittest.TestCase):
+    # Three instructions, then a branch over one more onto the zero word at 0x1014.
+    IMAGE = assemble_lines(["addi x5, x0, 1", "addi x6, x0, 2", "addi x7, x0, 3",
+                            "beq x0, x0, end", "addi x8, x0, 4", "end:"])
+
+    def test_budget_runs_out_just_before_a_halt(self):
+        for engine in RISCVSimulator.ENGINES:
+            self.assertEqual(run(self.IMAGE, engine, 4), (StopReason.BUDGET, 4, 0x1014), engine)
+            self.assertEqual(run(self.IMAGE, engine, 5), (StopReason.HALTED, 4, 0x1014), engine)
+
+    def test_stop_pc_on_a_halt(self):
+        for engine in RISCVSimulator.ENGINES:
+            for budget in (4, 5):
+                self.assertEqual(run(self.IMAGE, engine, budget, {0x1014}), (StopReason.STOP_PC, 4, 0x1014),
+                                 (engine, budget))
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,91 @@
+# Tests for stepping backwards through RISCVSimulator's execution history.
+#
+# Usage: python -m unittest test_history   (from Src/)
+
+import unittest
+
+import assembler
+from benchmark import read_source
+from simulator_core import RISCVSimulator
+
+def fib_image():
+    lines = read_source('fib')
+    return bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+
+def reference(instructions):
+    """pc and registers after running fib for exactly `instructions` instructions."""
+    sim = RISCVSimulator(engine='interp')
+    sim.load_image(fib_image())
+    sim.run(instructions)
+    return sim.pc, list(sim.registers)
+
+def unrecorded(instructions, **history):
+    sim = RISCVSimulator(engine='block')
+    sim.enable_history(**history)
+    sim.load_image(fib_image())
+    sim.history.recording = False
+    sim.run(instructions)
+    sim.history.recording = True
+    return sim
+
+class StepBack(unittest.TestCase):
+    def test_replay_is_not_counted_again(self):
+        sim = unrecorded(0)
+        sim.enable_profiling()
+        sampler = sim.enable_sampling(100)
+        sim.history.recording = False
+        sim.run(200_000)
+        sim.history.recording = True
+        samples = dict(sampler.samples)
+        self.assertEqual(sim.step_back(1), 1)
+        self.assertEqual(sim.stats.summary()['instructions'], 200_000)
+        self.assertEqual(sum(sim.profile.instruction_counts().values()), 200_000)
+        self.assertEqual(sampler.samples, samples)
+        self.assertEqual((sim.pc, list(sim.registers)), reference(199_999))
+
+    def test_within_the_ring(self):
+        sim = RISCVSimulator(engine='block')
+        sim.enable_history()
+        sim.load_image(fib_image())
+        sim.run(5000)
+        for back, position in ((1, 4999), (100, 4899), (4899, 0)):
+            self.assertEqual(sim.step_back(back), back)
+            self.assertEqual((sim.pc, list(sim.registers)), reference(position))
+        self.assertEqual(sim.step_back(1), 0)
+
+    def test_across_recorded_and_unrecorded_stretches(self):
+        sim = RISCVSimulator(engine='block')
+        sim.enable_history()
+        sim.load_image(fib_image())
+        sim.run(100)
+        sim.history.recording = False
+        sim.run(200_000)
+        sim.history.recording = True
+        sim.run(50)
+        self.assertEqual(sim.step_back(200_100), 200_100)
+        self.assertEqual((sim.pc, list(sim.registers)), reference(50))
+
+    def test_older_than_every_checkpoint(self):
+        sim = unrecorded(950, capacity=64, checkpoint_interval=100, max_checkpoints=4)
+        self.assertEqual(sim.step_back(200), 200)
+        # Only the checkpoints at 600 and 700 are left; 500 back goes as far as 600.
+        self.assertEqual(sim.step_back(500), 150)
+        self.assertEqual((sim.pc, list(sim.registers)), reference(600))
+        self.assertEqual(sim.step_back(10**6), 0)
+
+    def test_run_back_to_write(self):
+        sim = RISCVSimulator(engine='block')
+        sim.enable_history()
+        sim.load_image(fib_image())
+        sim.run(1000)
+        history = sim.history
+        last = max(position for position in range(history.oldest, history.position)
+                   if history.rds[position % history.capacity] == 10)
+        self.assertEqual(sim.run_back_to_write(10), 1000 - last)
+        self.assertEqual((sim.pc, list(sim.registers)), reference(last))
+        self.assertIsNone(sim.run_back_to_write(0))
+        self.assertIsNone(sim.run_back_to_write(31))  # fib never writes t6
+        self.assertEqual(history.position, last)
+
+if __name__ == "__main__":
+    unittest.main()
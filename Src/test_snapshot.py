@@ -0,0 +1,62 @@
+# Tests for RISCVSimulator.save_snapshot / load_snapshot.
+#
+# Usage: python -m unittest test_snapshot   (from Src/)
+
+import os
+import tempfile
+import unittest
+
+import assembler
+from benchmark import read_source
+from simulator_core import RISCVSimulator
+
+def sieve_image():
+    lines = read_source('sieve')
+    return bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+
+def state(sim):
+    return sim.pc, list(sim.registers), dict(sim.memory.nonzero_pages())
+
+class SnapshotRoundTrip(unittest.TestCase):
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.path = os.path.join(self.directory.name, 'same.snap')
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def test_save_over_the_mapped_snapshot(self):
+        reference = RISCVSimulator()
+        reference.load_image(sieve_image())
+        reference.run(6000)
+
+        sim = RISCVSimulator()
+        sim.load_image(sieve_image())
+        sim.run(5000)
+        sim.save_snapshot(self.path)
+        sim.load_snapshot(self.path)  # pages now live in a mapping of self.path
+        sim.run(1000)
+        sim.save_snapshot(self.path)
+        self.assertEqual(state(sim), state(reference))
+        self.assertEqual(os.listdir(self.directory.name), ['same.snap'])
+
+        # The first mapping still reads the old file, and the new one restores the same state.
+        sim.run(1000)
+        reference.run(1000)
+        self.assertEqual(state(sim), state(reference))
+        restored = RISCVSimulator()
+        restored.load_snapshot(self.path)
+        restored.run(1000)
+        self.assertEqual(state(restored), state(reference))
+
+    def test_copying_load(self):
+        sim = RISCVSimulator()
+        sim.load_image(sieve_image())
+        sim.run(5000)
+        sim.save_snapshot(self.path)
+        restored = RISCVSimulator()
+        restored.load_snapshot(self.path, use_mmap=False)
+        self.assertEqual(state(restored), state(sim))
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,86 @@
+# Regression tests for RISCVSimulator.stats on self-modifying code.
+# The 'interp' engine counts runs in batches (see Statistics); a store over code that
+# already ran must close the open run with the instructions it actually executed.
+#
+# Usage: python -m unittest test_statistics   (from Src/)
+
+import random
+import unittest
+
+import assembler
+from simulator_core import RISCVSimulator
+
+def assemble_lines(source):
+    lines = [assembler.clean_line(line) for line in source if assembler.clean_line(line)]
+    return bytes(assembler.second_pass(lines, assembler.first_pass(lines)))
+
+def run(image, engine, budget=10_000, history=False):
+    sim = RISCVSimulator(engine=engine)
+    if history: sim.enable_history()
+    sim.load_image(image)
+    result = sim.run(budget)
+    return sim, result
+
+def random_program(rng, length=24):
+    """Loads, stores and jumps over its own code (at 0x1000, base in x2), bounded by a countdown in x9."""
+    out = ["lui x2, 1", "addi x9, x0, 40"]
+    for i in range(length):
+        out.append(f"L{i}:")
+        kind = rng.random()
+        if kind < 0.25:
+            out.append(f"lw x{rng.randint(5, 8)}, {4 * rng.randint(0, length + 4)}(x2)")
+        elif kind < 0.5:
+            out.append(f"sw x{rng.choice([0, 5, 6, 7, 8])}, {4 * rng.randint(0, length + 4)}(x2)")
+        elif kind < 0.6:
+            out.append(f"sh x{rng.randint(5, 8)}, {2 * rng.randint(0, 2 * length + 8)}(x2)")
+        elif kind < 0.75:
+            out.append(f"addi x{rng.randint(5, 8)}, x{rng.randint(5, 8)}, {rng.randint(-20, 20)}")
+        elif kind < 0.85:
+            out += ["addi x9, x9, -1", f"bne x9, x0, L{rng.randint(0, i)}"]
+        elif kind < 0.92:
+            out.append(f"jal x1, L{rng.randint(0, length - 1)}")
+        else:
+            out.append(f"jalr x0, x2, {4 * rng.randint(2, length)}")
+    out.append("halt: jal x0, halt")
+    return assemble_lines(out)
+
+class SelfModifyingCodeStatistics(unittest.TestCase):
+    def test_store_over_executed_instruction(self):
+        # Zeroes the addi at 0x1004 after it ran.
+        image = assemble_lines(["lui x2, 1", "addi x5, x0, 1", "sw x0, 4(x2)", "halt: jal x0, halt"])
+        for engine in RISCVSimulator.ENGINES:
+            sim, result = run(image, engine)
+            summary = sim.stats.summary()
+            self.assertEqual(result.instructions, 4, engine)
+            self.assertEqual(summary['instructions'], 4, engine)
+            self.assertEqual(summary['mnemonics'], {'lui': 1, 'addi': 1, 'sw': 1, 'jal': 1}, engine)
+
+    def test_loop_rewriting_its_own_head(self):
+        # Each iteration stores the lw at 0x1008 back over itself.
+        image = assemble_lines(["lui x2, 1", "addi x9, x0, 3",
+                                "loop: lw x5, 8(x2)", "sw x5, 8(x2)", "addi x9, x9, -1", "bne x9, x0, loop",
+                                "halt: jal x0, halt"])
+        for engine in RISCVSimulator.ENGINES:
+            sim, result = run(image, engine)
+            summary = sim.stats.summary()
+            self.assertEqual(result.instructions, 15, engine)
+            self.assertEqual(summary['instructions'], 15, engine)
+            self.assertEqual(summary['mnemonics']['jal'], 1, engine)
+            self.assertEqual(summary['classes']['branch_taken'], 2, engine)
+
+    def test_random_programs_match_recording_interpreter(self):
+        # The recording interpreter counts every instruction as it executes it.
+        for seed in range(200):
+            image = random_program(random.Random(seed))
+            for budget in (7, 50, 3000):
+                reference, _ = run(image, 'interp', budget, history=True)
+                sim, result = run(image, 'interp', budget)
+                self.assertEqual(sim.stats.summary(), reference.stats.summary(), (seed, budget))
+                for engine in ('block', 'jit'):
+                    sim, result = run(image, engine, budget)
+                    summary = sim.stats.summary()
+                    self.assertEqual(summary['instructions'], result.instructions, (engine, seed, budget))
+                    self.assertTrue(all(count >= 0 for count in summary['mnemonics'].values()), (engine, seed))
+
+if __name__ == "__main__":
+    unittest.main()
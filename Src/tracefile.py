@@ -0,0 +1,251 @@
+# Compressed, seekable execution traces.
+# A trace holds every instruction the simulator retired: its pc, instruction word, rd
+# write-back and memory access. Records are stored in chunks of up to CHUNK_RECORDS
+# instructions, each compressed on its own with zlib and split into columns:
+#   flags   one byte per instruction (FLAG_JUMP / FLAG_WORD / FLAG_WRITE)
+#   deltas  next pc - (pc + 4), only after a jump or taken branch
+#   words   the instruction word, only the first time the chunk runs that pc
+#   values  the value written to rd, only for instructions that write a register
+# A chunk header also holds the pc and registers it started with, so memory addresses
+# and store values can be recomputed rather than stored, and any chunk decodes on its
+# own. An index of (first record, file offset) per chunk at the end of the file lets
+# readers jump to instruction N by decompressing a single chunk.
+#
+# Usage: python tracefile.py trace.rvt [--start N] [-n COUNT]
+
+import argparse
+import bisect
+import queue
+import struct
+import sys
+import threading
+import zlib
+from array import array
+from collections import namedtuple
+
+from simulator_core import RISCVSimulator
+
+TRACE_MAGIC = b'RVTRACE\0'
+TRACE_VERSION = 1
+CHUNK_RECORDS = 1 << 16
+FLAG_JUMP, FLAG_WORD, FLAG_WRITE = 1, 2, 4
+_COLUMN_TYPES = 'BqII'  # flags, deltas, words, values
+
+# File: magic, u32 version, chunks, index, footer. Chunk: header then zlib payload.
+_HEADER = struct.Struct('<8sI')
+# compressed size, first record, record count, first pc, x0..x31, column lengths
+_CHUNK_HEADER = struct.Struct('<IQII32I4I')
+# index offset, chunk count, record count, magic
+_FOOTER = struct.Struct('<QQQ8s')
+
+MemoryAccess = namedtuple('MemoryAccess', ['store', 'address', 'size', 'value'])
+TraceRecord = namedtuple('TraceRecord', ['index', 'pc', 'word', 'rd', 'value', 'memory'])
+
+class TraceWriter:
+    """Writes a trace file from the columns RISCVSimulator's tracing interpreter fills.
+
+    Full chunks go to a background thread that compresses and writes them (zlib drops
+    the GIL while compressing), so the simulator keeps running meanwhile. close() writes
+    the index; a trace is only readable once it has been closed.
+    """
+    def __init__(self, filename, chunk_records=CHUNK_RECORDS, level=6):
+        self.file = open(filename, 'wb')
+        self.file.write(_HEADER.pack(TRACE_MAGIC, TRACE_VERSION))
+        self.chunk_records = chunk_records
+        self.level = level
+        self.records = 0  # records in chunks already handed to the writer thread
+        self.index = array('Q')
+        # Where the simulator left off; it starts a new chunk if the next run() differs.
+        self.end_pc, self.end_registers = None, None
+        self._start = None
+        self._new_columns()
+        self._queue = queue.Queue(maxsize=4)
+        self._error = None
+        self._thread = threading.Thread(target=self._write_chunks, daemon=True)
+        self._thread.start()
+
+    def _new_columns(self):
+        self.flags, self.deltas, self.words, self.values = (array(t) for t in _COLUMN_TYPES)
+        self.seen = {}  # pc -> decode entry whose word this chunk already holds
+
+    def columns(self):
+        return self.flags, self.deltas, self.words, self.values, self.seen
+
+    def cut(self, pc, registers):
+        """Ends the current chunk and starts the next one at pc with a copy of registers."""
+        self._flush()
+        self._start = (pc, registers[:])
+
+    def _flush(self):
+        if self.flags:
+            self._queue.put((self.records, self._start, self.flags, self.deltas, self.words, self.values))
+            self.records += len(self.flags)
+            self._new_columns()
+
+    def _write_chunks(self):
+        while True:
+            chunk = self._queue.get()
+            if chunk is None: return
+            try:
+                if self._error is None: self._write_chunk(*chunk)
+            except Exception as e:
+                self._error = e
+
+    def _write_chunk(self, first, start, *columns):
+        pc, registers = start
+        if sys.byteorder != 'little':
+            for column in columns: column.byteswap()
+        payload = zlib.compress(b''.join(column.tobytes() for column in columns), self.level)
+        self.index.extend((first, self.file.tell()))
+        self.file.write(_CHUNK_HEADER.pack(len(payload), first, len(columns[0]), pc, *registers,
+                                           *(len(column) for column in columns)))
+        self.file.write(payload)
+
+    def close(self):
+        if self.file.closed: return
+        self._flush()
+        self._queue.put(None)
+        self._thread.join()
+        try:
+            if self._error is not None: raise self._error
+            offset = self.file.tell()
+            index = array('Q', self.index)
+            if sys.byteorder != 'little': index.byteswap()
+            self.file.write(index.tobytes())
+            self.file.write(_FOOTER.pack(offset, len(self.index) // 2, self.records, TRACE_MAGIC))
+        finally:
+            self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+class TraceReader:
+    """Reads a closed trace file; len(reader), reader[n] and reader.records(start, stop).
+
+    Only the chunk holding `start` and those after it are decompressed. Memory accesses
+    are rebuilt from the register state; the value of a load into x0 is not recorded,
+    so it reads as None.
+    """
+    def __init__(self, filename):
+        self.file = open(filename, 'rb')
+        magic, version = _HEADER.unpack(self.file.read(_HEADER.size))
+        if magic != TRACE_MAGIC: raise ValueError(f"'{filename}' is not a trace file.")
+        if version != TRACE_VERSION: raise ValueError(f"Unsupported trace version {version}.")
+        self.file.seek(-_FOOTER.size, 2)
+        index_offset, chunks, self.length, magic = _FOOTER.unpack(self.file.read(_FOOTER.size))
+        if magic != TRACE_MAGIC: raise ValueError(f"'{filename}' has no index (was the writer closed?).")
+        self.file.seek(index_offset)
+        index = array('Q')
+        index.frombytes(self.file.read(16 * chunks))
+        if sys.byteorder != 'little': index.byteswap()
+        self.firsts, self.offsets = index[0::2], index[1::2]
+        self._decoded = {}
+
+    def __len__(self):
+        return self.length
+
+    def __getitem__(self, n):
+        if n < 0: n += self.length
+        if not 0 <= n < self.length: raise IndexError("trace record out of range")
+        return next(self.records(n, n + 1))
+
+    def records(self, start=0, stop=None):
+        """Yields the TraceRecords numbered start..stop-1."""
+        stop = self.length if stop is None else min(stop, self.length)
+        chunk = max(0, bisect.bisect_right(self.firsts, start) - 1)
+        while chunk < len(self.offsets) and self.firsts[chunk] < stop:
+            for record in self._chunk_records(chunk):
+                if record.index >= stop: return
+                if record.index >= start: yield record
+            chunk += 1
+
+    def _decode(self, word):
+        info = self._decoded.get(word)
+        if info is None:
+            handler, _, rs1, rs2, imm = RISCVSimulator.decode_word(word)
+            info = self._decoded[word] = (rs1, rs2, imm, RISCVSimulator.LOAD_SIZES.get(handler, 0),
+                                          RISCVSimulator.STORE_SIZES.get(handler, 0))
+        return info
+
+    def _chunk_records(self, chunk):
+        self.file.seek(self.offsets[chunk])
+        header = _CHUNK_HEADER.unpack(self.file.read(_CHUNK_HEADER.size))
+        size, first, pc = header[0], header[1], header[3]
+        registers = list(header[4:36])
+        payload = zlib.decompress(self.file.read(size))
+        columns, position = [], 0
+        for typecode, length in zip(_COLUMN_TYPES, header[36:40]):
+            column = array(typecode)
+            end = position + length * column.itemsize
+            column.frombytes(payload[position:end])
+            if sys.byteorder != 'little': column.byteswap()
+            columns.append(column)
+            position = end
+        flags, deltas, words, values = columns
+        code, d, w, v = {}, 0, 0, 0
+        for n, flag in enumerate(flags):
+            if flag & FLAG_WORD:
+                word = code[pc] = words[w]
+                w += 1
+            else:
+                word = code[pc]
+            rs1, rs2, imm, load, store = self._decode(word)
+            address = (registers[rs1] + imm) & 0xFFFFFFFF
+            rd, value, memory = 0, None, None
+            if store:
+                memory = MemoryAccess(True, address, store, registers[rs2] & ((1 << 8 * store) - 1))
+            if flag & FLAG_WRITE:
+                rd, value = (word >> 7) & 0x1F, values[v]
+                registers[rd] = value
+                v += 1
+            if load:
+                memory = MemoryAccess(False, address, load, None if value is None else value & ((1 << 8 * load) - 1))
+            yield TraceRecord(first + n, pc, word, rd, value, memory)
+            if flag & FLAG_JUMP:
+                pc = (pc + 4 + deltas[d]) & 0xFFFFFFFF
+                d += 1
+            else:
+                pc += 4
+
+    def close(self):
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+def format_record(record):
+    text = f"{record.index:>10}  {record.pc:#010x}: {RISCVSimulator.disassemble_word(record.word, record.pc):<28}"
+    if record.rd: text += f" x{record.rd}={record.value:#x}"
+    if record.memory is not None:
+        access = record.memory
+        value = '?' if access.value is None else f"{access.value:#x}"
+        text += f" [{'store' if access.store else 'load'}{access.size} {access.address:#010x} = {value}]"
+    return text.rstrip()
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Print records from a RISC-V execution trace.")
+    parser.add_argument('trace', help="trace file written by simulator_cli.py --trace")
+    parser.add_argument('--start', type=int, default=0, help="first record to print")
+    parser.add_argument('-n', '--count', type=int, default=20, help="number of records to print")
+    args = parser.parse_args(argv)
+    try:
+        reader = TraceReader(args.trace)
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error: {e}", file=sys.stderr)
+        return 1
+    with reader:
+        size = reader.file.seek(0, 2)
+        print(f"{len(reader)} records in {len(reader.offsets)} chunks, {size} bytes "
+              f"({size / max(1, len(reader)):.2f} bytes/instruction)")
+        for record in reader.records(args.start, args.start + args.count):
+            print(format_record(record))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())